@@ -1,5 +1,13 @@
 using System.Runtime.InteropServices;
 
+// Latencies in microseconds, measured by the native library on Predict and Load.
+// The Load values cover every MLP.Load of the process (reset by MLP.ResetLoadStats, not GetStats),
+// the others this model only
+public readonly record struct MLPStats(
+    long PredictCount, double PredictP50, double PredictP99, double PredictMax,
+    long LoadCount, double LoadP50, double LoadP99, double LoadMax,
+    long BytesAllocated);
+
 public class MLP : IDisposable
 {
     private IntPtr _modelPtr;
@@ -29,6 +37,37 @@ public class MLP : IDisposable
         NativeMLP.save_mlp_model(_modelPtr, path);
     }
 
+    // Only the non zero weights are written, Load reads both formats
+    public void SaveSparse(string path)
+    {
+        CheckDisposed();
+        NativeMLP.save_mlp_model_sparse(_modelPtr, path);
+    }
+
+    // Only the hidden layers are pruned, each keeps at least 5% of its weights.
+    // The pruned weights stay at 0 when training again, until ClearMask
+    public void Prune(double sparsity, bool perLayer = false, bool structured = false)
+    {
+        CheckDisposed();
+        if (!NativeMLP.prune_mlp(_modelPtr, sparsity, perLayer, structured))
+            throw new ArgumentOutOfRangeException(nameof(sparsity), "Sparsity must be between 0 and 1 and the model needs a hidden layer.");
+    }
+
+    public void ClearMask()
+    {
+        CheckDisposed();
+        NativeMLP.clear_mlp_mask(_modelPtr);
+    }
+
+    public double Density
+    {
+        get
+        {
+            CheckDisposed();
+            return NativeMLP.get_mlp_density(_modelPtr);
+        }
+    }
+
     public double[] Predict(double[] input)
     {
         CheckDisposed();
@@ -51,6 +90,24 @@ public class MLP : IDisposable
         return result;
     }
 
+    public MLPStats GetStats(bool reset = false)
+    {
+        CheckDisposed();
+
+        double[] stats = new double[9];
+        NativeMLP.get_mlp_stats(_modelPtr, stats, reset);
+
+        return new MLPStats(
+            (long)stats[0], stats[1], stats[2], stats[3],
+            (long)stats[4], stats[5], stats[6], stats[7],
+            (long)stats[8]);
+    }
+
+    public static void ResetLoadStats()
+    {
+        NativeMLP.reset_mlp_load_stats();
+    }
+
     public (double[] TrainErrors, double[] TestErrors) Train(
         double[] X_flat, int rows, int cols, 
         double[] Y_flat, int y_rows, int y_cols,
@@ -88,6 +145,15 @@ public class MLP : IDisposable
         }
     }
 
+    internal IntPtr Handle
+    {
+        get
+        {
+            CheckDisposed();
+            return _modelPtr;
+        }
+    }
+
     private void CheckDisposed()
     {
         if (_modelPtr == IntPtr.Zero) 
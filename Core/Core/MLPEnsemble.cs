@@ -0,0 +1,62 @@
+using System.Runtime.InteropServices;
+
+public enum EnsembleMode
+{
+    Average = 0,
+    Vote = 1
+}
+
+public class MLPEnsemble : IDisposable
+{
+    private IntPtr _ensemblePtr;
+
+    // The weights are copied by the native ensemble, the models can be disposed afterward
+    public MLPEnsemble(MLP[] models)
+    {
+        IntPtr[] handles = models.Select(m => m.Handle).ToArray();
+
+        _ensemblePtr = NativeMLP.create_mlp_ensemble(handles, handles.Length);
+        if (_ensemblePtr == IntPtr.Zero)
+            throw new ArgumentException("Models must share the same input and output size.");
+    }
+
+    public double[] Predict(double[] input, EnsembleMode mode = EnsembleMode.Average)
+    {
+        CheckDisposed();
+
+        bool ok = NativeMLP.predict_one_mlp_ensemble(
+            _ensemblePtr,
+            input,
+            input.Length,
+            (int)mode,
+            out IntPtr resultPtr,
+            out int resultSize
+        );
+        if (!ok)
+            throw new ArgumentException("Input size doesn't match the ensemble or unknown mode.");
+
+        // Marshal data from C++ to C#
+        double[] result = new double[resultSize];
+        Marshal.Copy(resultPtr, result, 0, resultSize);
+
+        // Free C++ memory
+        NativeMLP.free_buffer(resultPtr);
+
+        return result;
+    }
+
+    public void Dispose()
+    {
+        if (_ensemblePtr != IntPtr.Zero)
+        {
+            NativeMLP.release_mlp_ensemble(_ensemblePtr);
+            _ensemblePtr = IntPtr.Zero;
+        }
+    }
+
+    private void CheckDisposed()
+    {
+        if (_ensemblePtr == IntPtr.Zero)
+            throw new ObjectDisposedException("MLP ensemble has been disposed.");
+    }
+}
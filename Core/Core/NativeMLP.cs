@@ -38,6 +38,58 @@ internal static class NativeMLP
         int error_list_size
     );
 
+    // out_stats must hold 9 values, see MLPStats
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void get_mlp_stats(IntPtr model, [Out] double[] out_stats, bool reset);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void reset_mlp_load_stats();
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAs(UnmanagedType.I1)]
+    public static extern bool prune_mlp(IntPtr model, double sparsity, bool per_layer, bool structured);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void clear_mlp_mask(IntPtr model);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern double get_mlp_density(IntPtr model);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void save_mlp_model_sparse(IntPtr model, [MarshalAs(UnmanagedType.LPStr)] string filepath);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr create_mlp_ensemble(IntPtr[] models, int model_count);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAs(UnmanagedType.I1)]
+    public static extern bool predict_one_mlp_ensemble(
+        IntPtr ensemble,
+        double[] sample_input,
+        int sample_size,
+        int mode,
+        out IntPtr out_result,
+        out int out_count
+    );
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void release_mlp_ensemble(IntPtr ensemble);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr create_search_agent(
+        IntPtr model,
+        int grid_size,
+        int max_depth,
+        double time_budget_ms,
+        int thread_count
+    );
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int search_agent_action(IntPtr agent, int[] state, int size, [Out] double[] out_stats);
+
+    [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void release_search_agent(IntPtr agent);
+
     [DllImport(DllPath, CallingConvention = CallingConvention.Cdecl)]
     public static extern void free_buffer(IntPtr ptr);
 }
@@ -0,0 +1,50 @@
+// Last search of the native agent: deepest complete level, tree size, states sent to the MLP,
+// transposition table hits and elapsed time in microseconds
+public readonly record struct SearchStats(int Depth, long Nodes, long Evaluated, long TableHits, double ElapsedUs);
+
+public class SearchAgent : IDisposable
+{
+    private IntPtr _agentPtr;
+
+    public SearchStats LastStats { get; private set; }
+
+    // The weights are copied by the native agent, the model can be disposed afterward
+    public SearchAgent(MLP model, int gridSize = 16, int maxDepth = 8, double timeBudgetMs = 5.0, int threadCount = 0)
+    {
+        _agentPtr = NativeMLP.create_search_agent(model.Handle, gridSize, maxDepth, timeBudgetMs, threadCount);
+        if (_agentPtr == IntPtr.Zero)
+            throw new ArgumentException("The model input size doesn't match the game state of this grid.");
+    }
+
+    // One-hot action (Up, Right, Down, Left) for the Game.GetState vector
+    public bool[] NextAction(int[] gameState)
+    {
+        CheckDisposed();
+
+        double[] stats = new double[5];
+        int action = NativeMLP.search_agent_action(_agentPtr, gameState, gameState.Length, stats);
+        if (action < 0)
+            throw new ArgumentException("The game state doesn't match the grid of the agent.");
+
+        LastStats = new SearchStats((int)stats[0], (long)stats[1], (long)stats[2], (long)stats[3], stats[4]);
+
+        bool[] actions = new bool[4];
+        actions[action] = true;
+        return actions;
+    }
+
+    public void Dispose()
+    {
+        if (_agentPtr != IntPtr.Zero)
+        {
+            NativeMLP.release_search_agent(_agentPtr);
+            _agentPtr = IntPtr.Zero;
+        }
+    }
+
+    private void CheckDisposed()
+    {
+        if (_agentPtr == IntPtr.Zero)
+            throw new ObjectDisposedException("Search agent has been disposed.");
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "BlockSparseMatrix.hpp"
+
+namespace {
+    // the last block of a column is moved back to end on the last row so no block reads past x,
+    // the rows it shares with the previous block are stored as 0 in it
+    long block_start(const Eigen::MatrixXd &W, const long row) {
+        return std::min<long>(row, W.rows() - BlockSparseMatrix::BLOCK_ROWS);
+    }
+
+    bool block_is_zero(const Eigen::MatrixXd &W, const long row, const long col) {
+        const long count = std::min<long>(BlockSparseMatrix::BLOCK_ROWS, W.rows() - row);
+        return W.col(col).segment(row, count).isZero(0.0);
+    }
+}
+
+BlockSparseMatrix BlockSparseMatrix::from_dense(const Eigen::MatrixXd &W, const double max_density) {
+    if (W.rows() < BLOCK_ROWS) return {};
+
+    const long blocks_per_column = (W.rows() + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    const auto max_blocks = static_cast<long>(max_density * static_cast<double>(blocks_per_column * W.cols()));
+
+    // count first, stopping as soon as the matrix is known to be too dense (the usual case for a dense model)
+    long block_count = 0;
+    for (long j = 0; j < W.cols(); j++) {
+        for (long i = 0; i < W.rows(); i += BLOCK_ROWS) {
+            if (!block_is_zero(W, i, j) && ++block_count > max_blocks) {
+                return {};
+            }
+        }
+    }
+
+    BlockSparseMatrix result;
+    result.rows = W.rows();
+    result.cols = W.cols();
+    result.column_start.reserve(W.cols() + 1);
+    result.block_row.reserve(block_count);
+    result.values.reserve(block_count * BLOCK_ROWS);
+
+    for (long j = 0; j < W.cols(); j++) {
+        result.column_start.push_back(static_cast<long>(result.block_row.size()));
+        for (long i = 0; i < W.rows(); i += BLOCK_ROWS) {
+            if (block_is_zero(W, i, j)) continue;
+
+            const long start = block_start(W, i);
+            result.block_row.push_back(static_cast<int32_t>(start));
+            for (long k = start; k < start + BLOCK_ROWS; k++) {
+                result.values.push_back(k >= i ? W(k, j) : 0.0);
+            }
+        }
+    }
+    result.column_start.push_back(static_cast<long>(result.block_row.size()));
+
+    return result;
+}
+
+bool BlockSparseMatrix::is_empty() const {
+    return column_start.empty();
+}
+
+double BlockSparseMatrix::density() const {
+    const long blocks_per_column = (rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    if (blocks_per_column * cols == 0) return 0.0;
+    return static_cast<double>(block_row.size()) / static_cast<double>(blocks_per_column * cols);
+}
+
+void BlockSparseMatrix::multiply_transposed(const Eigen::VectorXd &x, Eigen::VectorXd &out) const {
+    using Block = Eigen::Map<const Eigen::Array<double, BLOCK_ROWS, 1>>;
+
+    out.resize(cols);
+    const double* x_data = x.data();
+    const double* block_values = values.data();
+
+    for (long j = 0; j < cols; j++) {
+        // two accumulators so consecutive blocks don't wait on each other's additions
+        Eigen::Array<double, BLOCK_ROWS, 1> even = Eigen::Array<double, BLOCK_ROWS, 1>::Zero();
+        Eigen::Array<double, BLOCK_ROWS, 1> odd = Eigen::Array<double, BLOCK_ROWS, 1>::Zero();
+
+        long b = column_start[j];
+        const long end = column_start[j + 1];
+        for (; b + 1 < end; b += 2) {
+            even += Block(block_values + b * BLOCK_ROWS) * Block(x_data + block_row[b]);
+            odd += Block(block_values + (b + 1) * BLOCK_ROWS) * Block(x_data + block_row[b + 1]);
+        }
+        if (b < end) {
+            even += Block(block_values + b * BLOCK_ROWS) * Block(x_data + block_row[b]);
+        }
+
+        out(j) = (even + odd).sum();
+    }
+}
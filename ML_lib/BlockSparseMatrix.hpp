@@ -0,0 +1,41 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_BLOCKSPARSEMATRIX_H
+#define ML_LIB_BLOCKSPARSEMATRIX_H
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <vector>
+
+// Weight matrix of a pruned layer, stored by columns as blocks of BLOCK_ROWS consecutive rows:
+// only the blocks holding a non zero weight are kept, each one is a small dense dot product
+// (vectorized) instead of a scattered access per weight like CSR.
+class BlockSparseMatrix {
+public:
+    static constexpr int BLOCK_ROWS = 4;
+    // above this share of stored blocks the dense GEMV of Eigen is faster (measured on the Models/ layers)
+    static constexpr double MAX_DENSITY = 0.5;
+
+private:
+    long rows = 0;
+    long cols = 0;
+    std::vector<long> column_start; // blocks of column j: [column_start[j], column_start[j+1])
+    std::vector<int32_t> block_row; // first row of each block
+    std::vector<double> values; // BLOCK_ROWS values per block, 0 past the last row
+
+public:
+    BlockSparseMatrix() = default;
+
+    // returns an empty matrix (is_empty()) if W is too dense for the sparse kernel to win
+    [[nodiscard]] static BlockSparseMatrix from_dense(const Eigen::MatrixXd& W, double max_density = MAX_DENSITY);
+
+    [[nodiscard]] bool is_empty() const;
+    [[nodiscard]] double density() const; // share of the blocks stored
+
+    // out = x^T W (as a column), same as the dense product in MLP::propagate
+    void multiply_transposed(const Eigen::VectorXd& x, Eigen::VectorXd& out) const;
+};
+
+#endif //ML_LIB_BLOCKSPARSEMATRIX_H
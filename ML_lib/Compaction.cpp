@@ -0,0 +1,213 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "Compaction.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+    // little endian reads (the library only targets x86 Windows / Linux)
+    uint64_t read64(const unsigned char* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t read32(const unsigned char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint64_t xxh_round(uint64_t acc, const uint64_t input) {
+        acc += input * PRIME_2;
+        acc = std::rotl(acc, 31);
+        return acc * PRIME_1;
+    }
+
+    uint64_t merge_round(uint64_t acc, const uint64_t value) {
+        acc ^= xxh_round(0, value);
+        return acc * PRIME_1 + PRIME_4;
+    }
+
+    // open addressing table (linear probing) from the state hash to the index of the distinct state
+    class StateTable {
+        std::vector<uint32_t> slots; // distinct index + 1, 0 = empty
+        size_t mask = 0;
+
+    public:
+        explicit StateTable(const size_t capacity) {
+            slots.assign(std::bit_ceil(std::max<size_t>(capacity, 16)), 0);
+            mask = slots.size() - 1;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return slots.size();
+        }
+
+        // calls same(index) for each stored state with this hash until it returns true
+        template <typename Same>
+        [[nodiscard]] long find(const uint64_t hash, const std::vector<uint64_t>& hashes, Same same) const {
+            for (size_t slot = hash & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+                const long index = slots[slot] - 1;
+                if (hashes[index] == hash && same(index)) return index;
+            }
+            return -1;
+        }
+
+        void insert(const uint64_t hash, const long index) {
+            size_t slot = hash & mask;
+            while (slots[slot] != 0) slot = (slot + 1) & mask;
+            slots[slot] = static_cast<uint32_t>(index + 1);
+        }
+    };
+}
+
+uint64_t xxhash64(const void *data, const size_t length, const uint64_t seed) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME_1 + PRIME_2;
+        uint64_t v2 = seed + PRIME_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME_1;
+
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+        }
+
+        hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    } else {
+        hash = seed + PRIME_5;
+    }
+
+    hash += static_cast<uint64_t>(length);
+
+    for (; p + 8 <= end; p += 8) {
+        hash ^= xxh_round(0, read64(p));
+        hash = std::rotl(hash, 27) * PRIME_1 + PRIME_4;
+    }
+    if (p + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read32(p)) * PRIME_1;
+        hash = std::rotl(hash, 23) * PRIME_2 + PRIME_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        hash ^= (*p) * PRIME_5;
+        hash = std::rotl(hash, 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+CompactDataset compact_dataset(const DataSource &data, const int batch_size) {
+    if (batch_size <= 0) {
+        throw std::runtime_error("compact_dataset, batch_size must be > 0");
+    }
+
+    const long input_size = data.get_input_size();
+    const long output_size = data.get_output_size();
+
+    std::vector<int16_t> states; // packed inputs of the distinct states, input_size each
+    std::vector<uint64_t> hashes;
+    std::vector<double> target_sums; // output_size each
+    std::vector<double> first_targets; // to spot the conflicts
+    std::vector<double> counts;
+    std::vector<bool> conflicts;
+
+    StateTable table(1024);
+    std::vector<int16_t> packed(input_size);
+    std::vector<long> indices;
+    Eigen::MatrixXd X_batch;
+    Eigen::MatrixXd Y_batch;
+
+    for (long start = 0; start < data.size(); start += batch_size) {
+        const long end = std::min<long>(start + batch_size, data.size());
+        indices.resize(end - start);
+        std::iota(indices.begin(), indices.end(), start);
+        data.fetch(indices, X_batch, Y_batch);
+
+        for (long j = 0; j < X_batch.cols(); j++) {
+            for (long i = 0; i < input_size; i++) {
+                const double value = X_batch(i, j);
+                if (value != std::round(value) || value < std::numeric_limits<int16_t>::min() ||
+                    value > std::numeric_limits<int16_t>::max()) {
+                    throw std::runtime_error("compact_dataset, input value isn't an int16: " + std::to_string(value));
+                }
+                packed[i] = static_cast<int16_t>(value);
+            }
+
+            const uint64_t hash = xxhash64(packed.data(), packed.size() * sizeof(int16_t));
+            const long found = table.find(hash, hashes, [&](const long index) {
+                return std::equal(packed.begin(), packed.end(), states.begin() + index * input_size);
+            });
+
+            if (found >= 0) {
+                counts[found] += 1.0;
+                for (long k = 0; k < output_size; k++) {
+                    target_sums[found * output_size + k] += Y_batch(k, j);
+                    if (Y_batch(k, j) != first_targets[found * output_size + k]) conflicts[found] = true;
+                }
+                continue;
+            }
+
+            const auto index = static_cast<long>(hashes.size());
+            states.insert(states.end(), packed.begin(), packed.end());
+            hashes.push_back(hash);
+            counts.push_back(1.0);
+            conflicts.push_back(false);
+            for (long k = 0; k < output_size; k++) {
+                target_sums.push_back(Y_batch(k, j));
+                first_targets.push_back(Y_batch(k, j));
+            }
+
+            // keep the table at most half full so the probes stay short
+            if (2 * hashes.size() > table.capacity()) {
+                table = StateTable(2 * table.capacity());
+                for (long k = 0; k < static_cast<long>(hashes.size()); k++) table.insert(hashes[k], k);
+            } else {
+                table.insert(hash, index);
+            }
+        }
+    }
+
+    const auto unique_count = static_cast<long>(hashes.size());
+    CompactDataset result;
+    result.input_count = data.size();
+    result.X = Eigen::Map<const Eigen::Matrix<int16_t, Eigen::Dynamic, Eigen::Dynamic>>(
+        states.data(), input_size, unique_count).cast<double>();
+    result.weights = Eigen::Map<const Eigen::VectorXd>(counts.data(), unique_count);
+    result.Y = Eigen::Map<const Eigen::MatrixXd>(target_sums.data(), output_size, unique_count);
+    result.Y.array().rowwise() /= result.weights.transpose().array();
+    result.conflict_count = std::count(conflicts.begin(), conflicts.end(), true);
+
+    return result;
+}
@@ -0,0 +1,30 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_COMPACTION_H
+#define ML_LIB_COMPACTION_H
+
+#include <Eigen/Dense>
+#include <cstdint>
+
+#include "DataSource.hpp"
+
+// Recorded data with the identical states merged
+struct CompactDataset {
+    Eigen::MatrixXd X; // one column per distinct state, in the order they were first seen
+    Eigen::MatrixXd Y; // mean of the targets recorded for the state, a soft target when they disagree
+    Eigen::VectorXd weights; // number of rows merged into each state
+    long input_count = 0;
+    long conflict_count = 0; // states recorded with different targets
+};
+
+// 64 bits xxHash (XXH64) of a buffer
+[[nodiscard]] uint64_t xxhash64(const void* data, size_t length, uint64_t seed = 0);
+
+// Hashes every state (inputs packed as int16, like BinaryDataSource) into an open addressing table,
+// states with the same hash are compared so collisions never merge different states.
+// Throws if an input isn't an integer in the int16 range
+[[nodiscard]] CompactDataset compact_dataset(const DataSource& data, int batch_size = 4096);
+
+#endif //ML_LIB_COMPACTION_H
@@ -0,0 +1,447 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "DataSource.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#if WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char MAGIC[4] = {'S', 'N', 'K', 'D'};
+    constexpr int32_t VERSION = 1;
+    constexpr int32_t WEIGHTED_VERSION = 2;
+    constexpr size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(int32_t) + sizeof(int64_t) + 2 * sizeof(int32_t);
+
+    // start of the doubles of a weighted file (targets then weights), aligned after the int16 inputs
+    size_t weighted_block_offset(const int64_t count, const int32_t input_size) {
+        const size_t end = HEADER_SIZE + static_cast<size_t>(count) * input_size * sizeof(int16_t);
+        return (end + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    }
+}
+
+// ============= MemoryDataSource ================
+
+MemoryDataSource::MemoryDataSource(const double *X_data, const long input_size,
+                                   const double *Y_data, const long output_size, const long sample_count,
+                                   const double *weights)
+    : X(X_data, input_size, sample_count), Y(Y_data, output_size, sample_count), weights(weights) {
+}
+
+MemoryDataSource::MemoryDataSource(const Eigen::MatrixXd &X, const Eigen::MatrixXd &Y, const double *weights)
+    : X(X.data(), X.rows(), X.cols()), Y(Y.data(), Y.rows(), Y.cols()), weights(weights) {
+    if (X.cols() != Y.cols()) {
+        throw std::runtime_error(
+            "MemoryDataSource, X.cols doesn't match the number of Y.cols "
+            "\nX.cols(): " + std::to_string(X.cols()) +
+            "\nY.cols(): " + std::to_string(Y.cols())
+        );
+    }
+}
+
+long MemoryDataSource::size() const {
+    return X.cols();
+}
+
+int MemoryDataSource::get_input_size() const {
+    return static_cast<int>(X.rows());
+}
+
+int MemoryDataSource::get_output_size() const {
+    return static_cast<int>(Y.rows());
+}
+
+void MemoryDataSource::fetch(const std::vector<long> &indices, Eigen::MatrixXd &X_out, Eigen::MatrixXd &Y_out) const {
+    X_out.resize(X.rows(), static_cast<Eigen::Index>(indices.size()));
+    Y_out.resize(Y.rows(), static_cast<Eigen::Index>(indices.size()));
+
+    for (size_t j = 0; j < indices.size(); j++) {
+        X_out.col(j) = X.col(indices[j]);
+        Y_out.col(j) = Y.col(indices[j]);
+    }
+}
+
+const double *MemoryDataSource::get_weights() const {
+    return weights;
+}
+
+// ============= BinaryDataSource ================
+
+BinaryDataSource::BinaryDataSource(const std::string &filepath) {
+#if WIN32
+    file_handle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("Cannot open file for reading: " + filepath);
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_handle, &file_size);
+    mapping_size = static_cast<size_t>(file_size.QuadPart);
+
+    mapping_handle = mapping_size > 0 ? CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    mapping = mapping_handle != nullptr ? MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping == nullptr) {
+        if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw std::runtime_error("Cannot map file: " + filepath);
+    }
+#else
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file for reading: " + filepath);
+    }
+
+    struct stat file_stat{};
+    fstat(fd, &file_stat);
+    mapping_size = static_cast<size_t>(file_stat.st_size);
+
+    void* address = mapping_size > 0 ? mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd); // the mapping keeps the file alive
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file: " + filepath);
+    }
+    madvise(address, mapping_size, MADV_RANDOM); // samples are drawn at random
+    mapping = address;
+#endif
+
+    // ===== read the header =====
+    const auto* bytes = static_cast<const char*>(mapping);
+    int32_t version = 0;
+    int64_t count = 0;
+    int32_t sizes[2] = {0, 0};
+
+    if (mapping_size >= HEADER_SIZE) {
+        std::memcpy(&version, bytes + sizeof(MAGIC), sizeof(int32_t));
+        std::memcpy(&count, bytes + sizeof(MAGIC) + sizeof(int32_t), sizeof(int64_t));
+        std::memcpy(sizes, bytes + sizeof(MAGIC) + sizeof(int32_t) + sizeof(int64_t), sizeof(sizes));
+    }
+
+    const bool weighted_file = version == WEIGHTED_VERSION;
+    size_t expected = 0;
+    if (count >= 0 && sizes[0] > 0 && sizes[1] > 0) {
+        expected = weighted_file
+            ? weighted_block_offset(count, sizes[0]) + static_cast<size_t>(count) * (sizes[1] + 1) * sizeof(double)
+            : HEADER_SIZE + static_cast<size_t>(count) * (sizes[0] + sizes[1]) * sizeof(int16_t);
+    }
+    if (mapping_size < HEADER_SIZE || std::memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0 ||
+        (version != VERSION && !weighted_file) || expected == 0 || mapping_size < expected) {
+        unmap();
+        throw std::runtime_error("Invalid or truncated dataset file: " + filepath);
+    }
+
+    this->sample_count = static_cast<long>(count);
+    this->input_size = sizes[0];
+    this->output_size = sizes[1];
+    this->samples = reinterpret_cast<const int16_t*>(bytes + HEADER_SIZE);
+    if (weighted_file) {
+        // the mapping is page aligned, so are the doubles after the padding
+        this->targets = reinterpret_cast<const double*>(bytes + weighted_block_offset(count, sizes[0]));
+        this->weights = this->targets + static_cast<size_t>(count) * sizes[1];
+    }
+}
+
+BinaryDataSource::~BinaryDataSource() {
+    unmap();
+}
+
+void BinaryDataSource::unmap() {
+#if WIN32
+    if (mapping != nullptr) UnmapViewOfFile(mapping);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    if (file_handle != nullptr) CloseHandle(file_handle);
+    mapping_handle = file_handle = nullptr;
+#else
+    if (mapping != nullptr) munmap(const_cast<void*>(mapping), mapping_size);
+#endif
+    mapping = nullptr;
+}
+
+long BinaryDataSource::size() const {
+    return sample_count;
+}
+
+int BinaryDataSource::get_input_size() const {
+    return input_size;
+}
+
+int BinaryDataSource::get_output_size() const {
+    return output_size;
+}
+
+void BinaryDataSource::fetch(const std::vector<long> &indices, Eigen::MatrixXd &X_out, Eigen::MatrixXd &Y_out) const {
+    using MapSample = Eigen::Map<const Eigen::Matrix<int16_t, Eigen::Dynamic, 1>>;
+    using MapTarget = Eigen::Map<const Eigen::VectorXd>;
+    const long stride = targets != nullptr ? input_size : input_size + output_size;
+
+    X_out.resize(input_size, static_cast<Eigen::Index>(indices.size()));
+    Y_out.resize(output_size, static_cast<Eigen::Index>(indices.size()));
+
+    for (size_t j = 0; j < indices.size(); j++) {
+        const int16_t* sample = samples + indices[j] * stride;
+        X_out.col(j) = MapSample(sample, input_size).cast<double>();
+        if (targets != nullptr) {
+            Y_out.col(j) = MapTarget(targets + indices[j] * output_size, output_size);
+        } else {
+            Y_out.col(j) = MapSample(sample + input_size, output_size).cast<double>();
+        }
+    }
+}
+
+const double *BinaryDataSource::get_weights() const {
+    return weights;
+}
+
+void BinaryDataSource::write(const std::string &filepath, const DataSource &data, const bool append) {
+    const auto input_size = static_cast<int32_t>(data.get_input_size());
+    const auto output_size = static_cast<int32_t>(data.get_output_size());
+    const double* new_weights = data.get_weights();
+    const int32_t version = new_weights != nullptr ? WEIGHTED_VERSION : VERSION;
+    int64_t count = 0;
+
+    if (new_weights != nullptr &&
+        std::any_of(new_weights, new_weights + data.size(), [](const double w) { return !(w >= 0.0) || std::isinf(w); })) {
+        throw std::runtime_error("BinaryDataSource::write, the sample weights must be finite and >= 0");
+    }
+
+    std::fstream out;
+    if (append) {
+        out.open(filepath, std::ios::binary | std::ios::in | std::ios::out);
+    }
+
+    // a weighted file keeps its targets and weights after the inputs, they are rewritten after the new inputs
+    std::vector<double> targets;
+    std::vector<double> weights;
+
+    if (out.is_open()) {
+        // check the existing header before adding samples at the end
+        char magic[4];
+        int32_t file_version = 0;
+        int32_t sizes[2] = {0, 0};
+        out.read(magic, sizeof(magic));
+        out.read(reinterpret_cast<char*>(&file_version), sizeof(int32_t));
+        out.read(reinterpret_cast<char*>(&count), sizeof(int64_t));
+        out.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+
+        if (!out || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || file_version != version || count < 0 ||
+            sizes[0] != input_size || sizes[1] != output_size) {
+            throw std::runtime_error(
+                "Cannot append to dataset file (invalid header, different sizes or weighted and unweighted samples mixed): " +
+                filepath);
+        }
+
+        if (version == WEIGHTED_VERSION) {
+            targets.resize(static_cast<size_t>(count) * output_size);
+            weights.resize(static_cast<size_t>(count));
+            out.seekg(static_cast<std::streamoff>(weighted_block_offset(count, input_size)), std::ios::beg);
+            out.read(reinterpret_cast<char*>(targets.data()), static_cast<std::streamsize>(targets.size() * sizeof(double)));
+            out.read(reinterpret_cast<char*>(weights.data()), static_cast<std::streamsize>(weights.size() * sizeof(double)));
+            if (!out) {
+                throw std::runtime_error("Cannot append to dataset file (truncated): " + filepath);
+            }
+            out.seekp(static_cast<std::streamoff>(HEADER_SIZE + static_cast<size_t>(count) * input_size * sizeof(int16_t)),
+                      std::ios::beg);
+        } else {
+            out.seekp(0, std::ios::end);
+        }
+    } else {
+        out.open(filepath, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open file for writing: " + filepath);
+        }
+
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&version), sizeof(int32_t));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(int64_t));
+        out.write(reinterpret_cast<const char*>(&input_size), sizeof(int32_t));
+        out.write(reinterpret_cast<const char*>(&output_size), sizeof(int32_t));
+    }
+
+    // ===== convert and write the samples =====
+    const int int16_values = version == WEIGHTED_VERSION ? input_size : input_size + output_size;
+    std::vector<int16_t> sample(int16_values);
+    auto to_int16 = [](const double value) {
+        if (value != std::round(value) ||
+            value < std::numeric_limits<int16_t>::min() || value > std::numeric_limits<int16_t>::max()) {
+            throw std::runtime_error("BinaryDataSource::write, value doesn't fit in an int16: " + std::to_string(value));
+        }
+        return static_cast<int16_t>(value);
+    };
+
+    // read the source by chunks so a file source is never fully decoded in memory
+    constexpr long chunk = 1024;
+    std::vector<long> indices;
+    Eigen::MatrixXd X;
+    Eigen::MatrixXd Y;
+
+    for (long start = 0; start < data.size(); start += chunk) {
+        indices.resize(std::min(chunk, data.size() - start));
+        std::iota(indices.begin(), indices.end(), start);
+        data.fetch(indices, X, Y);
+
+        for (Eigen::Index j = 0; j < X.cols(); j++) {
+            for (int r = 0; r < input_size; r++) sample[r] = to_int16(X(r, j));
+            if (version == WEIGHTED_VERSION) {
+                targets.insert(targets.end(), Y.col(j).data(), Y.col(j).data() + output_size);
+            } else {
+                for (int r = 0; r < output_size; r++) sample[input_size + r] = to_int16(Y(r, j));
+            }
+            out.write(reinterpret_cast<const char*>(sample.data()), sample.size() * sizeof(int16_t));
+        }
+    }
+
+    count += data.size();
+    if (version == WEIGHTED_VERSION) {
+        weights.insert(weights.end(), new_weights, new_weights + data.size());
+
+        const size_t inputs_end = HEADER_SIZE + static_cast<size_t>(count) * input_size * sizeof(int16_t);
+        constexpr char padding[sizeof(double)] = {};
+        out.write(padding, static_cast<std::streamsize>(weighted_block_offset(count, input_size) - inputs_end));
+        out.write(reinterpret_cast<const char*>(targets.data()), static_cast<std::streamsize>(targets.size() * sizeof(double)));
+        out.write(reinterpret_cast<const char*>(weights.data()), static_cast<std::streamsize>(weights.size() * sizeof(double)));
+    }
+
+    // update the sample count once everything is written
+    out.seekp(sizeof(MAGIC) + sizeof(int32_t), std::ios::beg);
+    out.write(reinterpret_cast<const char*>(&count), sizeof(int64_t));
+
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error("Cannot write dataset file: " + filepath);
+    }
+}
+
+// ============= BatchLoader ================
+
+BatchLoader::BatchLoader(const DataSource &source, std::vector<long> candidates, const int batch_size,
+                         const bool prefetch, const unsigned int seed)
+    : source(source), candidates(std::move(candidates)), batch_size(batch_size), prefetch(prefetch), g(seed) {
+    if (this->candidates.empty() || batch_size <= 0) {
+        throw std::runtime_error("BatchLoader, expected at least one candidate and batch_size > 0");
+    }
+
+    if (const double* weights = source.get_weights()) {
+        std::vector<double> draw_weights;
+        draw_weights.reserve(this->candidates.size());
+        double weight_sum = 0.0;
+        double draw_sum = 0.0;
+        for (const long index : this->candidates) {
+            draw_weights.push_back(std::pow(weights[index], SAMPLING_POWER));
+            weight_sum += weights[index];
+            draw_sum += draw_weights.back();
+        }
+        if (!(weight_sum > 0.0)) {
+            throw std::runtime_error("BatchLoader, the candidates all have a weight of 0");
+        }
+        weighted_pick = std::discrete_distribution<size_t>(draw_weights.begin(), draw_weights.end());
+
+        // importance weight = full data probability / draw probability, normalized and bounded
+        candidate_step_weights.reserve(this->candidates.size());
+        for (size_t c = 0; c < this->candidates.size(); c++) {
+            const double w = weights[this->candidates[c]];
+            candidate_step_weights.push_back(
+                draw_weights[c] > 0.0 ? std::min(MAX_STEP_WEIGHT, (w / draw_weights[c]) * (draw_sum / weight_sum)) : 0.0);
+        }
+    }
+
+    if (prefetch) {
+        buffers.resize(QUEUE_DEPTH + 1);
+        reader = std::thread(&BatchLoader::read_loop, this);
+    } else {
+        buffers.resize(1);
+    }
+}
+
+BatchLoader::~BatchLoader() {
+    // the reader uses the buffers, stop it (a pending error is dropped)
+    if (reader.joinable()) {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        freed.notify_all();
+        reader.join();
+    }
+}
+
+void BatchLoader::read_loop() {
+    const int capacity = static_cast<int>(buffers.size());
+    while (true) {
+        int slot;
+        {
+            std::unique_lock lock(mutex);
+            freed.wait(lock, [&] { return stopping || queued + (held ? 1 : 0) < capacity; });
+            if (stopping) return;
+            slot = tail;
+        }
+
+        // the buffer is neither queued nor held, it is only touched here until it is queued
+        try {
+            fill(buffers[slot]);
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            error = std::current_exception();
+            filled.notify_one();
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            tail = (tail + 1) % capacity;
+            queued++;
+        }
+        filled.notify_one();
+    }
+}
+
+void BatchLoader::fill(Batch &batch) {
+    std::uniform_int_distribution<size_t> pick(0, candidates.size() - 1);
+
+    const bool weighted = !candidate_step_weights.empty();
+
+    batch.indices.resize(batch_size);
+    batch.step_weights.resize(weighted ? batch_size : 0);
+    for (int j = 0; j < batch_size; j++) {
+        const size_t c = weighted ? weighted_pick(g) : pick(g);
+        batch.indices[j] = candidates[c];
+        if (weighted) batch.step_weights[j] = candidate_step_weights[c];
+    }
+
+    source.fetch(batch.indices, batch.X, batch.Y);
+}
+
+const Batch &BatchLoader::next() {
+    if (!prefetch) {
+        fill(buffers[0]);
+        return buffers[0];
+    }
+
+    std::unique_lock lock(mutex);
+    held = false; // the previous batch can be refilled
+    freed.notify_one();
+
+    filled.wait(lock, [&] { return queued > 0 || error; });
+    if (queued == 0) std::rethrow_exception(error); // the batches read before the error are used first
+
+    const int slot = head;
+    head = (head + 1) % static_cast<int>(buffers.size());
+    queued--;
+    held = true;
+    return buffers[slot];
+}
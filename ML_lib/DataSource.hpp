@@ -0,0 +1,152 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_DATASOURCE_H
+#define ML_LIB_DATASOURCE_H
+
+#include <Eigen/Dense>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Samples are columns, like the X and Y given to MLP::train
+class DataSource {
+public:
+    virtual ~DataSource() = default;
+
+    [[nodiscard]] virtual long size() const = 0;
+    [[nodiscard]] virtual int get_input_size() const = 0;
+    [[nodiscard]] virtual int get_output_size() const = 0;
+
+    // copy the samples at the given indices into the columns of X and Y (resized if needed)
+    // must be safe to call from another thread while the source isn't modified
+    virtual void fetch(const std::vector<long>& indices, Eigen::MatrixXd& X, Eigen::MatrixXd& Y) const = 0;
+
+    // size() per sample weights (e.g. how many recorded rows a compacted sample stands for), nullptr = all 1
+    [[nodiscard]] virtual const double* get_weights() const { return nullptr; }
+};
+
+// View over samples already in memory (not copied, they must outlive the source)
+class MemoryDataSource final : public DataSource {
+    Eigen::Map<const Eigen::MatrixXd> X;
+    Eigen::Map<const Eigen::MatrixXd> Y;
+    const double* weights;
+
+public:
+    MemoryDataSource(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y, const double* weights = nullptr);
+    // column-major buffers, one sample per column (e.g. a C-ordered numpy array of shape (samples, features))
+    MemoryDataSource(const double* X_data, long input_size, const double* Y_data, long output_size, long sample_count,
+                     const double* weights = nullptr);
+
+    [[nodiscard]] long size() const override;
+    [[nodiscard]] int get_input_size() const override;
+    [[nodiscard]] int get_output_size() const override;
+
+    void fetch(const std::vector<long>& indices, Eigen::MatrixXd& X_out, Eigen::MatrixXd& Y_out) const override;
+    [[nodiscard]] const double* get_weights() const override;
+};
+
+// Memory mapped dataset file, the inputs stored as int16 (the recorded states are small integers).
+// Layout: "SNKD", int32 version, int64 sample_count, int32 input_size, int32 output_size, then
+// - version 1 (no sample weights): per sample input_size + output_size int16 values
+// - version 2 (weighted, e.g. a compacted dataset): per sample input_size int16 values, zero padding
+//   up to a multiple of 8 bytes, sample_count * output_size doubles (the targets, averaged when
+//   compacted) then sample_count double weights
+class BinaryDataSource final : public DataSource {
+    long sample_count = 0;
+    int input_size = 0;
+    int output_size = 0;
+    const int16_t* samples = nullptr;
+    const double* targets = nullptr; // version 2 only, output_size per sample
+    const double* weights = nullptr; // version 2 only
+
+    const void* mapping = nullptr;
+    size_t mapping_size = 0;
+#if WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+
+    void unmap();
+
+public:
+    explicit BinaryDataSource(const std::string& filepath);
+    ~BinaryDataSource() override;
+    BinaryDataSource(const BinaryDataSource&) = delete;
+    BinaryDataSource& operator=(const BinaryDataSource&) = delete;
+
+    [[nodiscard]] long size() const override;
+    [[nodiscard]] int get_input_size() const override;
+    [[nodiscard]] int get_output_size() const override;
+
+    void fetch(const std::vector<long>& indices, Eigen::MatrixXd& X_out, Eigen::MatrixXd& Y_out) const override;
+    [[nodiscard]] const double* get_weights() const override;
+
+    // throws if a value isn't an integer in the int16 range (only the inputs when the source has sample
+    // weights, written as version 2). append = true adds the samples to an existing file (sizes and
+    // version must match), so big datasets can be converted in chunks
+    static void write(const std::string& filepath, const DataSource& data, bool append = false);
+};
+
+struct Batch {
+    std::vector<long> indices;
+    Eigen::MatrixXd X;
+    Eigen::MatrixXd Y;
+    std::vector<double> step_weights; // factor on the update of each sample, empty without sample weights
+};
+
+// Draws random batches among the candidate indices. With sample weights, a sample of weight w is drawn in
+// proportion to w^SAMPLING_POWER, so the rare states are seen more often than in the full data, and its
+// step weight w^(1 - SAMPLING_POWER) * sum(w^SAMPLING_POWER) / sum(w), capped at MAX_STEP_WEIGHT, brings
+// the expected update back to the full data one (mean of 1 over the draws, less once capped).
+// With prefetch, one reader thread decodes the following batches into a bounded queue while the
+// caller works on the current one
+class BatchLoader {
+    static constexpr int QUEUE_DEPTH = 2; // batches decoded ahead of the caller
+
+public:
+    static constexpr double SAMPLING_POWER = 0.5;
+    static constexpr double MAX_STEP_WEIGHT = 4.0;
+
+private:
+    const DataSource& source;
+    std::vector<long> candidates;
+    int batch_size;
+    bool prefetch;
+    std::mt19937 g;
+    std::discrete_distribution<size_t> weighted_pick; // only used when the source has sample weights
+    std::vector<double> candidate_step_weights; // same order as candidates, empty without sample weights
+
+    // ring of QUEUE_DEPTH + 1 buffers: the queued ones, then the one the caller holds
+    std::vector<Batch> buffers;
+    int head = 0; // next queued batch handed out
+    int tail = 0; // next buffer the reader fills
+    int queued = 0;
+    bool held = false; // the caller still uses buffers[head - 1]
+    bool stopping = false;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable filled;
+    std::condition_variable freed;
+    std::thread reader;
+
+    void fill(Batch& batch);
+    void read_loop();
+
+public:
+    BatchLoader(const DataSource& source, std::vector<long> candidates, int batch_size, bool prefetch, unsigned int seed);
+    ~BatchLoader();
+    BatchLoader(const BatchLoader&) = delete;
+    BatchLoader& operator=(const BatchLoader&) = delete;
+
+    // valid until the next call
+    [[nodiscard]] const Batch& next();
+};
+
+#endif //ML_LIB_DATASOURCE_H
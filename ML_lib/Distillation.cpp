@@ -0,0 +1,143 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "Distillation.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+    // "SNKT", int32 version, int64 sample_count, int32 output_size, then the outputs as column-major doubles
+    constexpr char MAGIC[4] = {'S', 'N', 'K', 'T'};
+    constexpr int32_t VERSION = 1;
+}
+
+// ============= TeacherOutputs ================
+
+TeacherOutputs::TeacherOutputs(const MLP &teacher, const DataSource &data, const int batch_size) {
+    if (data.get_input_size() != teacher.get_input_size()) {
+        throw std::runtime_error(
+            "TeacherOutputs, the data input size doesn't match the teacher input size"
+            "\nGot: " + std::to_string(data.get_input_size()) +
+            "\nExpected: " + std::to_string(teacher.get_input_size())
+        );
+    }
+    if (batch_size <= 0) {
+        throw std::runtime_error("TeacherOutputs, batch_size must be > 0");
+    }
+
+    outputs.resize(teacher.get_output_size(), data.size());
+
+    std::vector<long> indices;
+    Eigen::MatrixXd X_batch;
+    Eigen::MatrixXd Y_batch;
+    for (long start = 0; start < data.size(); start += batch_size) {
+        const long end = std::min<long>(start + batch_size, data.size());
+        indices.resize(end - start);
+        std::iota(indices.begin(), indices.end(), start);
+
+        data.fetch(indices, X_batch, Y_batch);
+        outputs.middleCols(start, end - start) = teacher.predict_batch(X_batch);
+    }
+}
+
+TeacherOutputs::TeacherOutputs(const std::string &filepath) {
+    std::ifstream in(filepath, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open file for reading: " + filepath);
+    }
+
+    char magic[sizeof(MAGIC)] = {};
+    int32_t version = 0;
+    int64_t count = 0;
+    int32_t output_size = 0;
+    in.read(magic, sizeof(MAGIC));
+    in.read(reinterpret_cast<char*>(&version), sizeof(int32_t));
+    in.read(reinterpret_cast<char*>(&count), sizeof(int64_t));
+    in.read(reinterpret_cast<char*>(&output_size), sizeof(int32_t));
+    if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || count < 0 || output_size <= 0) {
+        throw std::runtime_error("Invalid teacher outputs file: " + filepath);
+    }
+
+    outputs.resize(output_size, static_cast<long>(count));
+    in.read(reinterpret_cast<char*>(outputs.data()), outputs.size() * sizeof(double));
+    if (!in) {
+        throw std::runtime_error("Truncated teacher outputs file: " + filepath);
+    }
+}
+
+const Eigen::MatrixXd& TeacherOutputs::get_outputs() const {
+    return outputs;
+}
+
+long TeacherOutputs::size() const {
+    return outputs.cols();
+}
+
+int TeacherOutputs::get_output_size() const {
+    return static_cast<int>(outputs.rows());
+}
+
+void TeacherOutputs::save(const std::string &filepath) const {
+    std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + filepath);
+    }
+
+    const auto count = static_cast<int64_t>(outputs.cols());
+    const auto output_size = static_cast<int32_t>(outputs.rows());
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char*>(&VERSION), sizeof(int32_t));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(int64_t));
+    out.write(reinterpret_cast<const char*>(&output_size), sizeof(int32_t));
+    out.write(reinterpret_cast<const char*>(outputs.data()), outputs.size() * sizeof(double));
+}
+
+// ============= DistillationDataSource ================
+
+DistillationDataSource::DistillationDataSource(const DataSource &data, const TeacherOutputs &teacher,
+                                               const double teacher_weight)
+    : data(data), teacher(teacher), teacher_weight(teacher_weight) {
+    if (teacher.size() != data.size() || teacher.get_output_size() != data.get_output_size()) {
+        throw std::runtime_error(
+            "DistillationDataSource, the teacher outputs don't match the data"
+            "\nGot: " + std::to_string(teacher.size()) + " samples of " + std::to_string(teacher.get_output_size()) +
+            "\nExpected: " + std::to_string(data.size()) + " samples of " + std::to_string(data.get_output_size())
+        );
+    }
+    if (teacher_weight < 0.0 || teacher_weight > 1.0) {
+        throw std::runtime_error(
+            "DistillationDataSource, teacher_weight must be between 0 and 1"
+            "\nGot: " + std::to_string(teacher_weight)
+        );
+    }
+}
+
+long DistillationDataSource::size() const {
+    return data.size();
+}
+
+int DistillationDataSource::get_input_size() const {
+    return data.get_input_size();
+}
+
+int DistillationDataSource::get_output_size() const {
+    return data.get_output_size();
+}
+
+void DistillationDataSource::fetch(const std::vector<long> &indices, Eigen::MatrixXd &X, Eigen::MatrixXd &Y) const {
+    data.fetch(indices, X, Y);
+
+    const Eigen::MatrixXd &soft = teacher.get_outputs();
+    for (size_t j = 0; j < indices.size(); j++) {
+        Y.col(static_cast<long>(j)) = teacher_weight * soft.col(indices[j]) + (1.0 - teacher_weight) * Y.col(static_cast<long>(j));
+    }
+}
+
+const double *DistillationDataSource::get_weights() const {
+    return data.get_weights();
+}
@@ -0,0 +1,50 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_DISTILLATION_H
+#define ML_LIB_DISTILLATION_H
+
+#include <Eigen/Dense>
+#include <string>
+#include <vector>
+
+#include "DataSource.hpp"
+#include "MLP.hpp"
+
+// Outputs of a teacher MLP on every sample of a data source, computed once by batches (one GEMM
+// per layer instead of a forward pass per sample) so several students can be trained from them
+class TeacherOutputs {
+    Eigen::MatrixXd outputs; // output_size x sample_count, same order as the source
+
+public:
+    TeacherOutputs(const MLP& teacher, const DataSource& data, int batch_size = 1024);
+    // outputs saved by save, the sample count must match the source they are used with
+    explicit TeacherOutputs(const std::string& filepath);
+
+    [[nodiscard]] const Eigen::MatrixXd& get_outputs() const;
+    [[nodiscard]] long size() const;
+    [[nodiscard]] int get_output_size() const;
+
+    void save(const std::string& filepath) const;
+};
+
+// The samples of a source with the teacher outputs as targets:
+// Y = teacher_weight * teacher + (1 - teacher_weight) * recorded
+class DistillationDataSource final : public DataSource {
+    const DataSource& data;
+    const TeacherOutputs& teacher;
+    double teacher_weight;
+
+public:
+    DistillationDataSource(const DataSource& data, const TeacherOutputs& teacher, double teacher_weight = 1.0);
+
+    [[nodiscard]] long size() const override;
+    [[nodiscard]] int get_input_size() const override;
+    [[nodiscard]] int get_output_size() const override;
+
+    void fetch(const std::vector<long>& indices, Eigen::MatrixXd& X, Eigen::MatrixXd& Y) const override;
+    [[nodiscard]] const double* get_weights() const override;
+};
+
+#endif //ML_LIB_DISTILLATION_H
@@ -0,0 +1,256 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "EvolutionStrategies.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    uint64_t splitmix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    long weight_count(const std::vector<Eigen::MatrixXd> &weights) {
+        long count = 0;
+        for (size_t l = 1; l < weights.size(); l++) count += weights[l].size();
+        return count;
+    }
+
+    // weights[1..L] one after the other, column-major
+    Eigen::VectorXd flatten(const std::vector<Eigen::MatrixXd> &weights) {
+        Eigen::VectorXd flat(weight_count(weights));
+        long offset = 0;
+        for (size_t l = 1; l < weights.size(); l++) {
+            flat.segment(offset, weights[l].size()) = weights[l].reshaped();
+            offset += weights[l].size();
+        }
+        return flat;
+    }
+
+    void unflatten(const Eigen::VectorXd &flat, std::vector<Eigen::MatrixXd> &weights) {
+        long offset = 0;
+        for (size_t l = 1; l < weights.size(); l++) {
+            weights[l].reshaped() = flat.segment(offset, weights[l].size());
+            offset += weights[l].size();
+        }
+    }
+
+    // calls job(index, worker) for every index in [0, count), over thread_count threads
+    template <typename Job>
+    void run_parallel(const int count, const int thread_count, Job job) {
+        std::atomic<int> next{0};
+        std::vector<std::exception_ptr> errors(thread_count);
+
+        auto worker = [&](const int w) {
+            try {
+                for (int index = next++; index < count; index = next++) job(index, w);
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(thread_count - 1);
+        for (int w = 1; w < thread_count; w++) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto &thread : pool) thread.join();
+
+        for (const auto &error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    // centered ranks in [-0.5, 0.5], the update doesn't depend on the scale of the fitness
+    Eigen::VectorXd centered_ranks(const Eigen::VectorXd &fitness) {
+        std::vector<int> order(fitness.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) { return fitness(a) < fitness(b); });
+
+        Eigen::VectorXd ranks(fitness.size());
+        for (int r = 0; r < static_cast<int>(order.size()); r++) {
+            ranks(order[r]) = static_cast<double>(r) / static_cast<double>(fitness.size() - 1) - 0.5;
+        }
+        return ranks;
+    }
+}
+
+void es_noise(const uint64_t seed, const long begin, const long end, double *out) {
+    // Box-Muller, one hash per pair of values
+    for (long pair = begin / 2; 2 * pair < end; pair++) {
+        const uint64_t h = splitmix64(seed ^ splitmix64(static_cast<uint64_t>(pair)));
+        const double u1 = (static_cast<double>(h >> 32) + 0.5) / 4294967296.0; // never 0
+        const double u2 = static_cast<double>(h & 0xFFFFFFFFULL) / 4294967296.0;
+        const double radius = std::sqrt(-2.0 * std::log(u1));
+        const double angle = 2.0 * std::numbers::pi * u2;
+
+        const long first = 2 * pair;
+        if (first >= begin) out[first - begin] = radius * std::cos(angle);
+        if (first + 1 >= begin && first + 1 < end) out[first + 1 - begin] = radius * std::sin(angle);
+    }
+}
+
+EvolutionTrainer::EvolutionTrainer(FitnessFunction fitness, const EvolutionOptions &options)
+    : fitness(std::move(fitness)), options(options) {
+    if (!this->fitness) {
+        throw std::runtime_error("EvolutionTrainer, no fitness function");
+    }
+    if (options.population < 2 || options.population % 2 != 0) {
+        throw std::runtime_error(
+            "EvolutionTrainer, population must be even and >= 2"
+            "\nGot: " + std::to_string(options.population)
+        );
+    }
+    if (options.generations <= 0 || options.sigma <= 0.0) {
+        throw std::runtime_error("EvolutionTrainer, generations and sigma must be > 0");
+    }
+}
+
+EvolutionResults EvolutionTrainer::train(MLP &model) const {
+    int thread_count = options.thread_count;
+    if (thread_count <= 0) thread_count = static_cast<int>(std::thread::hardware_concurrency());
+    if (thread_count <= 0) thread_count = 1;
+    thread_count = std::min(thread_count, options.population + 1);
+
+    const int population = options.population;
+    const int pair_count = population / 2;
+
+    Eigen::VectorXd theta = flatten(*model.get_weights());
+    const long n = theta.size();
+
+    // one candidate model and buffers per worker, created up front: the MLP constructor relies on std::rand
+    std::vector<std::unique_ptr<MLP>> candidates;
+    std::vector<std::vector<Eigen::MatrixXd>> candidate_weights(thread_count, *model.get_weights());
+    std::vector<Eigen::VectorXd> noise(thread_count, Eigen::VectorXd(n));
+    for (int w = 0; w < thread_count; w++) {
+        candidates.push_back(std::make_unique<MLP>(*model.get_neuron_per_layer(), model.is_classification()));
+    }
+
+    auto evaluate = [&](const Eigen::VectorXd &flat, const int w) {
+        unflatten(flat, candidate_weights[w]);
+        candidates[w]->set_weights(candidate_weights[w]);
+        return fitness(*candidates[w]);
+    };
+
+    EvolutionResults results;
+    results.center_fitness.resize(options.generations);
+    results.mean_fitness.resize(options.generations);
+    results.max_fitness.resize(options.generations);
+
+    double best_fitness = -std::numeric_limits<double>::infinity();
+    Eigen::VectorXd best_theta = theta;
+
+    std::mt19937_64 generation_seeds(options.seed);
+    std::vector<uint64_t> seeds(pair_count);
+    Eigen::VectorXd member_fitness(population + 1); // the last one is the unperturbed center
+
+    for (int generation = 0; generation < options.generations; generation++) {
+        const uint64_t generation_seed = generation_seeds();
+        for (int p = 0; p < pair_count; p++) seeds[p] = splitmix64(generation_seed + p);
+
+        // ===== evaluate the population, the members of a pair share their noise =====
+        run_parallel(population + 1, thread_count, [&](const int member, const int w) {
+            if (member == population) {
+                member_fitness(member) = evaluate(theta, w);
+                return;
+            }
+            es_noise(seeds[member / 2], 0, n, noise[w].data());
+            const double sign = member % 2 == 0 ? 1.0 : -1.0;
+            noise[w] = theta + (sign * options.sigma) * noise[w];
+            member_fitness(member) = evaluate(noise[w], w);
+        });
+
+        const Eigen::VectorXd members = member_fitness.head(population);
+        results.center_fitness(generation) = member_fitness(population);
+        results.mean_fitness(generation) = members.mean();
+        results.max_fitness(generation) = members.maxCoeff();
+
+        if (member_fitness(population) > best_fitness) {
+            best_fitness = member_fitness(population);
+            best_theta = theta;
+            results.best_generation = generation;
+        }
+
+        // ===== update, each worker regenerates the noise of every pair on its own slice of the weights =====
+        const Eigen::VectorXd ranks = centered_ranks(members);
+        Eigen::VectorXd pair_weights(pair_count);
+        for (int p = 0; p < pair_count; p++) pair_weights(p) = ranks(2 * p) - ranks(2 * p + 1);
+        const double step = options.learning_rate / (population * options.sigma);
+
+        const long slice = (n + thread_count - 1) / thread_count;
+        run_parallel(thread_count, thread_count, [&](const int s, const int w) {
+            const long begin = s * slice;
+            const long end = std::min(n, begin + slice);
+            if (begin >= end) return;
+
+            Eigen::VectorXd gradient = Eigen::VectorXd::Zero(end - begin);
+            for (int p = 0; p < pair_count; p++) {
+                es_noise(seeds[p], begin, end, noise[w].data());
+                gradient += pair_weights(p) * noise[w].head(end - begin);
+            }
+            theta.segment(begin, end - begin) += step * gradient;
+        });
+    }
+
+    // the last update hasn't been evaluated yet
+    const double final_fitness = evaluate(theta, 0);
+    if (final_fitness > best_fitness) {
+        best_theta = theta;
+        results.best_generation = options.generations;
+    }
+
+    std::vector<Eigen::MatrixXd> best_weights = *model.get_weights();
+    unflatten(best_theta, best_weights);
+    model.set_weights(best_weights);
+
+    return results;
+}
+
+FitnessFunction dataset_fitness(const DataSource &data, const int batch_size) {
+    if (batch_size <= 0) {
+        throw std::runtime_error("dataset_fitness, batch_size must be > 0");
+    }
+    if (data.size() == 0) {
+        throw std::runtime_error("dataset_fitness, empty data");
+    }
+
+    auto X = std::make_shared<Eigen::MatrixXd>();
+    auto Y = std::make_shared<Eigen::MatrixXd>();
+    std::vector<long> indices(data.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    data.fetch(indices, *X, *Y);
+
+    return [X, Y, batch_size](const MLP &model) {
+        double total = 0.0;
+        for (long start = 0; start < X->cols(); start += batch_size) {
+            const long count = std::min<long>(batch_size, X->cols() - start);
+            const Eigen::MatrixXd prediction = model.predict_batch(Eigen::MatrixXd(X->middleCols(start, count)));
+
+            for (long j = 0; j < count; j++) {
+                if (model.is_classification()) {
+                    Eigen::Index predicted, expected;
+                    prediction.col(j).maxCoeff(&predicted);
+                    Y->col(start + j).maxCoeff(&expected);
+                    total += predicted == expected ? 1.0 : 0.0;
+                } else {
+                    total -= (prediction.col(j) - Y->col(start + j)).squaredNorm() / static_cast<double>(Y->rows());
+                }
+            }
+        }
+        return total / static_cast<double>(X->cols());
+    };
+}
@@ -0,0 +1,57 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_EVOLUTIONSTRATEGIES_H
+#define ML_LIB_EVOLUTIONSTRATEGIES_H
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <functional>
+
+#include "DataSource.hpp"
+#include "MLP.hpp"
+
+struct EvolutionOptions {
+    int population = 64; // even, members go by mirrored pairs (+noise, -noise)
+    int generations = 100;
+    double sigma = 0.02; // standard deviation of the weight noise
+    double learning_rate = 0.01;
+    int thread_count = 0; // 0 = one per hardware thread
+    uint64_t seed = 0; // same seed and fitness = same result, whatever the thread count
+};
+
+struct EvolutionResults {
+    Eigen::VectorXd center_fitness; // fitness of the unperturbed weights at each generation
+    Eigen::VectorXd mean_fitness; // mean over the population
+    Eigen::VectorXd max_fitness;
+    int best_generation = -1; // the model ends with the weights of this generation (== generations for the final ones)
+};
+
+// Higher is better. Called concurrently from the worker threads, each with its own candidate model
+using FitnessFunction = std::function<double(const MLP&)>;
+
+// standard normal values [begin, end) of the noise vector of a seed, any slice can be regenerated on its own
+void es_noise(uint64_t seed, long begin, long end, double* out);
+
+// Gradient free training (OpenAI-ES): every generation, population candidates are the current weights
+// plus seeded noise, evaluated over a thread pool. The weights then move along the noise weighted by the
+// centered rank of each candidate's fitness. Only seeds and fitness values are shared between the workers,
+// each one regenerates the noise it needs. The pruning mask isn't applied
+class EvolutionTrainer {
+    FitnessFunction fitness;
+    EvolutionOptions options;
+
+public:
+    EvolutionTrainer(FitnessFunction fitness, const EvolutionOptions& options);
+    ~EvolutionTrainer() = default;
+
+    // starts from the current weights (e.g. a loaded .bin model) and leaves the best ones seen in model
+    [[nodiscard]] EvolutionResults train(MLP& model) const;
+};
+
+// Accuracy (argmax match) for classification models, minus the MSE for regression, over the whole source.
+// The samples are fetched once and kept in memory, each evaluation is a batched predict
+[[nodiscard]] FitnessFunction dataset_fitness(const DataSource& data, int batch_size = 1024);
+
+#endif //ML_LIB_EVOLUTIONSTRATEGIES_H
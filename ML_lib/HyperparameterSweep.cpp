@@ -0,0 +1,144 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "HyperparameterSweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "MLP.hpp"
+
+HyperparameterSweep::HyperparameterSweep(const bool isClassification, const int error_list_size) {
+    this->isClassification = isClassification;
+    this->error_list_size = error_list_size;
+}
+
+const std::vector<SweepConfig>* HyperparameterSweep::get_configs() const {
+    return &configs;
+}
+
+void HyperparameterSweep::add_grid(const std::vector<Eigen::VectorXi> &topologies, const std::vector<int> &num_iters,
+                                   const std::vector<double> &learning_rates,
+                                   const std::vector<double> &train_proportions) {
+    for (const auto &NPL : topologies) {
+        for (const int num_iter : num_iters) {
+            for (const double lr : learning_rates) {
+                for (const double train_proportion : train_proportions) {
+                    configs.push_back({NPL, num_iter, lr, train_proportion});
+                }
+            }
+        }
+    }
+}
+
+void HyperparameterSweep::add_random(const std::vector<Eigen::VectorXi> &topologies, const std::vector<int> &num_iters,
+                                     const double lr_min, const double lr_max,
+                                     const std::vector<double> &train_proportions,
+                                     const int sample_count, const unsigned int seed) {
+    if (topologies.empty() || num_iters.empty() || train_proportions.empty()) {
+        throw std::runtime_error("HyperparameterSweep::add_random, topologies, num_iters and train_proportions can't be empty");
+    }
+    if (lr_min <= 0.0 || lr_max < lr_min) {
+        throw std::runtime_error("HyperparameterSweep::add_random, expected 0 < lr_min <= lr_max");
+    }
+
+    std::mt19937 g(seed);
+    std::uniform_real_distribution<double> log_lr(std::log(lr_min), std::log(lr_max));
+
+    auto pick = [&g](const auto &values) {
+        std::uniform_int_distribution<size_t> index(0, values.size() - 1);
+        return values[index(g)];
+    };
+
+    for (int i = 0; i < sample_count; i++) {
+        configs.push_back({pick(topologies), pick(num_iters), std::exp(log_lr(g)), pick(train_proportions)});
+    }
+}
+
+std::string HyperparameterSweep::model_name(const long sample_count, const SweepConfig &config) {
+    std::ostringstream name;
+    name << sample_count << "X_[";
+    for (int l = 0; l < config.NPL.size(); l++) {
+        name << (l == 0 ? "" : ", ") << config.NPL(l);
+    }
+    name << "]_" << config.num_iter << "iter_" << config.learning_rate << "lr_" << config.train_proportion << "train.bin";
+    return name.str();
+}
+
+std::vector<SweepResult> HyperparameterSweep::run(const Eigen::MatrixXd &X, const Eigen::MatrixXd &Y,
+                                                  const std::string &output_dir, int thread_count) const {
+    if (thread_count <= 0) thread_count = static_cast<int>(std::thread::hardware_concurrency());
+    if (thread_count <= 0) thread_count = 1;
+    thread_count = std::min(thread_count, static_cast<int>(configs.size()));
+
+    std::filesystem::create_directories(output_dir);
+
+    // models are created up front: Eigen's Random initialisation relies on std::rand, which isn't thread-safe
+    std::vector<std::unique_ptr<MLP>> models;
+    models.reserve(configs.size());
+    for (const auto &config : configs) {
+        models.push_back(std::make_unique<MLP>(config.NPL, isClassification));
+    }
+
+    std::vector<SweepResult> results(configs.size());
+    std::atomic<size_t> next_job{0};
+
+    // each worker pulls the next config until the list is exhausted, X and Y are only read
+    auto worker = [&]() {
+        for (size_t job = next_job++; job < configs.size(); job = next_job++) {
+            const SweepConfig &config = configs[job];
+            const std::string name = model_name(X.cols(), config);
+            results[job].model_name = name;
+            try {
+                TrainingResults training = models[job]->train(X, Y, config.num_iter, config.learning_rate,
+                                                               config.train_proportion, error_list_size);
+
+                models[job]->save((std::filesystem::path(output_dir) / name).string());
+
+                const Eigen::Index last = training.train_errors.size() - 1;
+                results[job].final_train_error = training.train_errors(last);
+                results[job].final_test_error = training.test_errors(last);
+            } catch (const std::exception &e) {
+                results[job].error = e.what();
+            } catch (...) {
+                results[job].error = "unknown error";
+            }
+            models[job].reset(); // release the weights as soon as the model is saved
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(thread_count);
+    for (int t = 0; t < thread_count; t++) {
+        pool.emplace_back(worker);
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    // ===== summary table =====
+    const std::string summary_path = (std::filesystem::path(output_dir) / "sweep-summary.csv").string();
+    std::ofstream summary(summary_path, std::ios::trunc);
+    if (!summary.is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + summary_path);
+    }
+
+    summary << "model,train_mse,test_mse,error\n";
+    for (const auto &result : results) {
+        std::string error = result.error;
+        std::replace(error.begin(), error.end(), '"', '\'');
+        summary << '"' << result.model_name << "\"," << result.final_train_error << ',' << result.final_test_error
+                << ",\"" << error << "\"\n";
+    }
+
+    return results;
+}
@@ -0,0 +1,57 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_HYPERPARAMETERSWEEP_H
+#define ML_LIB_HYPERPARAMETERSWEEP_H
+
+#include <Eigen/Dense>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct SweepConfig {
+    Eigen::VectorXi NPL;
+    int num_iter;
+    double learning_rate;
+    double train_proportion;
+};
+
+struct SweepResult {
+    std::string model_name;
+    double final_train_error = std::numeric_limits<double>::quiet_NaN(); // NaN when the job failed
+    double final_test_error = std::numeric_limits<double>::quiet_NaN();
+    std::string error; // what() of the exception that stopped the job, empty if it succeeded
+};
+
+class HyperparameterSweep {
+    std::vector<SweepConfig> configs;
+    bool isClassification;
+    int error_list_size;
+
+public:
+    explicit HyperparameterSweep(bool isClassification = true, int error_list_size = 100);
+    ~HyperparameterSweep() = default;
+
+    [[nodiscard]] const std::vector<SweepConfig>* get_configs() const;
+
+    // every combination of the given values
+    void add_grid(const std::vector<Eigen::VectorXi>& topologies, const std::vector<int>& num_iters,
+                  const std::vector<double>& learning_rates, const std::vector<double>& train_proportions);
+
+    // sample_count configs, learning rate drawn log-uniformly in [lr_min, lr_max], the rest picked from the lists
+    void add_random(const std::vector<Eigen::VectorXi>& topologies, const std::vector<int>& num_iters,
+                    double lr_min, double lr_max, const std::vector<double>& train_proportions,
+                    int sample_count, unsigned int seed);
+
+    // Models/ naming convention: [NumberOfExamples]X_[Layers]_[iter]iter_[lr]lr_[train]train.bin
+    [[nodiscard]] static std::string model_name(long sample_count, const SweepConfig& config);
+
+    // Trains every config on the same read-only X and Y (one sample per column) over thread_count threads
+    // (0 = one per hardware thread), saves each model in output_dir and writes output_dir/sweep-summary.csv.
+    // A failing job only marks its own result (error set, NaN errors), the others are still saved and reported
+    [[nodiscard]] std::vector<SweepResult> run(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y,
+                                               const std::string& output_dir, int thread_count = 0) const;
+};
+
+#endif //ML_LIB_HYPERPARAMETERSWEEP_H
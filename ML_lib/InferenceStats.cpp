@@ -0,0 +1,141 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "InferenceStats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+    std::atomic<int> next_shard{0};
+
+    // threads are spread round-robin over the shards the first time they record
+    int shard_index() {
+        thread_local const int shard = next_shard.fetch_add(1, std::memory_order_relaxed) % LatencyHistogram::SHARD_COUNT;
+        return shard;
+    }
+}
+
+int LatencyHistogram::bucket_index(const uint64_t nanoseconds) {
+    if (nanoseconds < SUB_BUCKETS) {
+        return static_cast<int>(nanoseconds); // exact below 16 ns
+    }
+
+    const int exponent = 63 - std::countl_zero(nanoseconds); // position of the highest bit
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    const auto sub_bucket = static_cast<int>((nanoseconds >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_value(const int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+
+    const int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKETS;
+    const uint64_t width = uint64_t{1} << (exponent - SUB_BUCKET_BITS);
+    return ((SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS)) + width / 2;
+}
+
+void LatencyHistogram::record(const uint64_t nanoseconds) {
+    shards[shard_index()].counts[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+    // the max only changes on a new worst case, so contention on it stays rare
+    uint64_t current = max_value.load(std::memory_order_relaxed);
+    while (nanoseconds > current &&
+           !max_value.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto &shard : shards) {
+        for (auto &bucket : shard.counts) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    max_value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto &shard : shards) {
+        for (const auto &bucket : shard.counts) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::max() const {
+    return max_value.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(const double percent) const {
+    // merge the shards (records arriving meanwhile may or may not be counted)
+    std::array<uint64_t, BUCKET_COUNT> merged{};
+    uint64_t total = 0;
+    for (const auto &shard : shards) {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            const uint64_t bucket = shard.counts[i].load(std::memory_order_relaxed);
+            merged[i] += bucket;
+            total += bucket;
+        }
+    }
+    if (total == 0) return 0;
+
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total))));
+    uint64_t cumulative = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        cumulative += merged[i];
+        if (cumulative >= rank) {
+            return std::min(bucket_value(i), max());
+        }
+    }
+    return max();
+}
+
+void InferenceStats::reset() {
+    predict.reset();
+    bytes_allocated.store(0, std::memory_order_relaxed);
+}
+
+LazyInferenceStats::~LazyInferenceStats() {
+    delete stats.load(std::memory_order_acquire);
+}
+
+LazyInferenceStats::LazyInferenceStats(LazyInferenceStats &&other) noexcept
+    : stats(other.stats.exchange(nullptr, std::memory_order_acq_rel)) {}
+
+LazyInferenceStats &LazyInferenceStats::operator=(LazyInferenceStats &&other) noexcept {
+    if (this != &other) {
+        delete stats.exchange(other.stats.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_acq_rel);
+    }
+    return *this;
+}
+
+const InferenceStats &LazyInferenceStats::get() const {
+    static const InferenceStats empty;
+    const InferenceStats* current = stats.load(std::memory_order_acquire);
+    return current != nullptr ? *current : empty;
+}
+
+InferenceStats &LazyInferenceStats::for_recording() {
+    InferenceStats* current = stats.load(std::memory_order_acquire);
+    if (current != nullptr) return *current;
+
+    // two threads may allocate at the same time, the loser frees its copy
+    auto* created = new InferenceStats();
+    if (stats.compare_exchange_strong(current, created, std::memory_order_acq_rel)) return *created;
+    delete created;
+    return *current;
+}
+
+void LazyInferenceStats::reset() {
+    if (InferenceStats* current = stats.load(std::memory_order_acquire)) current->reset();
+}
@@ -0,0 +1,91 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_INFERENCESTATS_H
+#define ML_LIB_INFERENCESTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Log-linear latency histogram (HDR-like): 16 sub-buckets per power of two, so any value is
+// known within ~6%. Each thread records into its own shard with relaxed atomics (no lock),
+// shards are only merged when reading.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 40; // 2^40 ns ~ 18 min, slower calls land in the last bucket
+    static constexpr int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    static constexpr int SHARD_COUNT = 8;
+
+    void record(uint64_t nanoseconds);
+    void reset();
+
+    [[nodiscard]] uint64_t count() const;
+    [[nodiscard]] uint64_t max() const;
+    // value under which percent % of the records are (0 if empty), in ns
+    [[nodiscard]] uint64_t percentile(double percent) const;
+
+    [[nodiscard]] static int bucket_index(uint64_t nanoseconds);
+    [[nodiscard]] static uint64_t bucket_value(int index); // middle of the bucket
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts{};
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<uint64_t> max_value{0};
+};
+
+struct InferenceStats {
+    LatencyHistogram predict;
+    std::atomic<uint64_t> bytes_allocated{0}; // buffers handed to the caller and loaded weights
+
+    void reset();
+};
+
+// InferenceStats of one model handle, allocated on the first record (the histograms take ~39 KB each,
+// most models are never measured). A copy starts without counters, they belong to the handle
+class LazyInferenceStats {
+    mutable std::atomic<InferenceStats*> stats{nullptr};
+
+public:
+    LazyInferenceStats() = default;
+    ~LazyInferenceStats();
+    LazyInferenceStats(const LazyInferenceStats&) {}
+    LazyInferenceStats& operator=(const LazyInferenceStats&) {
+        return *this;
+    }
+    LazyInferenceStats(LazyInferenceStats&& other) noexcept;
+    LazyInferenceStats& operator=(LazyInferenceStats&& other) noexcept;
+
+    // empty counters until something is recorded
+    [[nodiscard]] const InferenceStats& get() const;
+    // allocates the counters on the first call, safe from several threads
+    [[nodiscard]] InferenceStats& for_recording();
+    void reset();
+};
+
+// records the time spent in its scope
+class ScopedLatency {
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+};
+
+#endif //ML_LIB_INFERENCESTATS_H
@@ -3,10 +3,25 @@
 //
 
 #include "MLP.hpp"
-
+#include "DataSource.hpp"
+#include "Distillation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
 #include <numeric>
 #include <random>
 
+namespace {
+    // the dense format starts with the isClassification bool, so the first byte tells them apart
+    constexpr char SPARSE_MAGIC[4] = {'S', 'N', 'K', 'S'};
+    constexpr int32_t SPARSE_VERSION = 1;
+}
+
 const Eigen::VectorXi* MLP::get_neuron_per_layer() const {
     return &NPL;
 }
@@ -19,6 +34,10 @@ int MLP::get_output_size() const {
     return NPL(L);
 }
 
+bool MLP::is_classification() const {
+    return isClassification;
+}
+
 const std::vector<Eigen::MatrixXd>* MLP::get_weights() const {
     return &weights;
 }
@@ -61,6 +80,15 @@ void MLP::propagate(const Eigen::VectorXd &X_input) {
 
     // update all layers until output
     for (int l = 1; l <= L; l++) {
+        if (!sparse_weights.empty() && !sparse_weights[l].is_empty()) {
+            // pruned layer, only the stored blocks are read
+            sparse_weights[l].multiply_transposed(this->X[l-1], this->X[l]);
+            if (this->isClassification || l != L) {
+                this->X[l] = this->X[l].array().tanh();
+            }
+            continue;
+        }
+
         Eigen::VectorXd signal = this->X[l-1].transpose() * weights[l];
 
         if (this->isClassification || l != L) {
@@ -72,14 +100,220 @@ void MLP::propagate(const Eigen::VectorXd &X_input) {
     }
 }
 
+double MLP::backpropagate(const Eigen::VectorXd &Y_bias) {
+    deltas[L] = this->X[L] - Y_bias;
+
+    const double MSE = deltas[L].array().square().mean();
+
+    if (this->isClassification) {
+        deltas[L] = deltas[L].array() * (1.0 - this->X[L].array().square()).array();
+    }
+
+    // get the deltas
+    for (int l = L; l >= 2; l--) {
+        deltas[l-1] = (1.0 - this->X[l-1].array().square()).matrix().cwiseProduct(weights[l] * deltas[l]); // (1 - X[l-1]**2) * (W[l] @ deltas[l])
+    }
+
+    return MSE;
+}
+
+std::vector<Eigen::MatrixXd> MLP::gradients(const Eigen::VectorXd &X_input, const Eigen::VectorXd &Y) {
+    if (Y.size() != this->NPL(L)) {
+        throw std::runtime_error(
+            "MLP::gradients, Y.size doesn't match the size of the MLP output"
+            "\nGot Y.size(): " + std::to_string(Y.size()) +
+            "\nExpected: " + std::to_string(this->NPL(L))
+        );
+    }
+
+    Eigen::VectorXd Y_bias = Eigen::VectorXd::Ones(Y.size() + 1);
+    Y_bias.tail(Y.size()) = Y;
+
+    propagate(X_input);
+    backpropagate(Y_bias);
+
+    // same update direction as train: W[l] -= learning_rate * X[l-1] * deltas[l]^T
+    std::vector<Eigen::MatrixXd> result(L + 1);
+    for (int l = 1; l <= L; l++) {
+        result[l] = this->X[l-1] * deltas[l].transpose();
+    }
+    return result;
+}
+
+void MLP::set_weights(const std::vector<Eigen::MatrixXd> &new_weights) {
+    if (new_weights.size() != weights.size()) {
+        throw std::runtime_error(
+            "MLP::set_weights, expected " + std::to_string(weights.size()) +
+            " matrices, got " + std::to_string(new_weights.size())
+        );
+    }
+    for (int l = 1; l <= L; l++) {
+        if (new_weights[l].rows() != weights[l].rows() || new_weights[l].cols() != weights[l].cols()) {
+            throw std::runtime_error("MLP::set_weights, wrong shape for layer " + std::to_string(l));
+        }
+    }
+
+    weights = new_weights;
+    masks.clear(); // the mask of an earlier prune doesn't apply to other weights
+    update_sparse_kernels();
+}
+
+void MLP::update_sparse_kernels() {
+    sparse_weights.clear();
+    sparse_weights.resize(L + 1);
+    for (int l = 1; l <= L; l++) {
+        sparse_weights[l] = BlockSparseMatrix::from_dense(weights[l]);
+    }
+}
+
+void MLP::prune(const PruningOptions &options) {
+    if (options.sparsity < 0.0 || options.sparsity > 1.0 ||
+        options.min_layer_density < 0.0 || options.min_layer_density > 1.0) {
+        throw std::runtime_error(
+            "MLP::prune, sparsity and min_layer_density must be between 0 and 1"
+            "\nGot: " + std::to_string(options.sparsity) + ", " + std::to_string(options.min_layer_density)
+        );
+    }
+    if (L < 2) {
+        throw std::runtime_error("MLP::prune, the output layer isn't pruned: the model needs a hidden layer");
+    }
+
+    // a unit is one weight, or a block of rows of one column when structured. Only the hidden layers are
+    // pruned (an empty output row loses its action) and never col(0), the weights of the bias neuron
+    const long unit_rows = options.structured ? BlockSparseMatrix::BLOCK_ROWS : 1;
+    const int last_pruned = L - 1;
+
+    std::vector<std::vector<double>> scores(L + 1);
+    for (int l = 1; l <= last_pruned; l++) {
+        const Eigen::MatrixXd &W = weights[l];
+        scores[l].reserve((W.cols() - 1) * ((W.rows() + unit_rows - 1) / unit_rows));
+        for (long j = 1; j < W.cols(); j++) {
+            for (long i = 0; i < W.rows(); i += unit_rows) {
+                scores[l].push_back(W.col(j).segment(i, std::min(unit_rows, W.rows() - i)).norm());
+            }
+        }
+    }
+
+    // units pruned in each layer: the same share everywhere, or the ones under one threshold for the whole
+    // net. Either way a layer keeps at least min_layer_density of its units (and one), so none is emptied
+    std::vector<long> pruned(L + 1, 0);
+    if (options.per_layer) {
+        for (int l = 1; l <= last_pruned; l++) {
+            pruned[l] = std::llround(options.sparsity * static_cast<double>(scores[l].size()));
+        }
+    } else {
+        std::vector<double> all;
+        for (int l = 1; l <= last_pruned; l++) all.insert(all.end(), scores[l].begin(), scores[l].end());
+        const auto k = static_cast<long>(std::llround(options.sparsity * static_cast<double>(all.size())));
+
+        if (k > 0) {
+            std::nth_element(all.begin(), all.begin() + (k - 1), all.end());
+            const double threshold = all[k - 1];
+
+            // ties at the threshold go to the first layers until exactly k units are
+            long ties = k - std::count_if(all.begin(), all.end(), [threshold](const double v) { return v < threshold; });
+            for (int l = 1; l <= last_pruned; l++) {
+                const long tied = std::count(scores[l].begin(), scores[l].end(), threshold);
+                const long taken = std::min(ties, tied);
+                ties -= taken;
+                pruned[l] = taken + std::count_if(scores[l].begin(), scores[l].end(),
+                                                  [threshold](const double v) { return v < threshold; });
+            }
+        }
+    }
+
+    if (masks.empty()) {
+        masks.resize(L + 1);
+        for (int l = 1; l <= L; l++) masks[l] = Eigen::MatrixXd::Ones(weights[l].rows(), weights[l].cols());
+    }
+
+    for (int l = 1; l <= last_pruned; l++) {
+        const auto units = static_cast<long>(scores[l].size());
+        const long kept = std::max(1L, static_cast<long>(std::ceil(options.min_layer_density * static_cast<double>(units))));
+        const long k = std::clamp(pruned[l], 0L, std::max(0L, units - kept));
+        if (k == 0) continue;
+
+        // the k smallest scores of the layer, ties at the threshold pruned in order
+        std::vector<double> sorted = scores[l];
+        std::nth_element(sorted.begin(), sorted.begin() + (k - 1), sorted.end());
+        const double threshold = sorted[k - 1];
+        long ties = k - std::count_if(sorted.begin(), sorted.end(), [threshold](const double v) { return v < threshold; });
+
+        const Eigen::MatrixXd &W = weights[l];
+        size_t unit = 0;
+        for (long j = 1; j < W.cols(); j++) {
+            for (long i = 0; i < W.rows(); i += unit_rows, unit++) {
+                const double score = scores[l][unit];
+                if (score < threshold || (score == threshold && ties-- > 0)) {
+                    masks[l].col(j).segment(i, std::min(unit_rows, W.rows() - i)).setZero();
+                }
+            }
+        }
+
+        weights[l].array() *= masks[l].array();
+    }
+
+    update_sparse_kernels();
+}
+
+void MLP::clear_mask() {
+    masks.clear();
+}
+
+double MLP::get_density() const {
+    // col(0) isn't pruned, counting it would make the pruning look deeper than it is
+    long total = 0;
+    long non_zero = 0;
+    for (int l = 1; l <= L; l++) {
+        const long cols = weights[l].cols() - 1;
+        total += weights[l].rows() * cols;
+        non_zero += (weights[l].rightCols(cols).array() != 0.0).count();
+    }
+    return total == 0 ? 0.0 : static_cast<double>(non_zero) / static_cast<double>(total);
+}
+
+int MLP::sparse_layer_count() const {
+    return static_cast<int>(std::count_if(sparse_weights.begin(), sparse_weights.end(),
+                                          [](const BlockSparseMatrix &W) { return !W.is_empty(); }));
+}
+
 Eigen::VectorXd MLP::predict(const Eigen::VectorXd &X_input) {
     propagate(X_input);
     return  this->X[L].segment(1, X[L].size()-1); // return output without the bias
 }
 
+Eigen::MatrixXd MLP::predict_batch(const Eigen::MatrixXd &X_input) const {
+    if (X_input.rows() != this->NPL(0)) {
+        throw std::runtime_error(
+            "MLP::predict_batch, X_input.rows doesn't match the size of the MLP input"
+            "\nGot X_input.rows(): " + std::to_string(X_input.rows()) +
+            "\nExpected: " + std::to_string(this->NPL(0))
+        );
+    }
+
+    // same as propagate with the samples side by side: X[l] = f(W[l]^T X[l-1]), bias neuron row included
+    Eigen::MatrixXd activations(X_input.rows() + 1, X_input.cols());
+    activations.row(0).setOnes();
+    activations.bottomRows(X_input.rows()) = X_input;
+
+    for (int l = 1; l <= L; l++) {
+        Eigen::MatrixXd signal = weights[l].transpose() * activations;
+
+        if (this->isClassification || l != L) {
+            activations = signal.array().tanh();
+        }
+        else {
+            activations = std::move(signal);
+        }
+    }
+
+    return activations.bottomRows(activations.rows() - 1); // output without the bias
+}
+
 TrainingResults MLP::train(const Eigen::MatrixXd &X_input, const Eigen::MatrixXd &Y,
                            const int num_iter, const double learning_rate,
-                           double train_proportion, int error_list_size) {
+                           const double train_proportion, const int error_list_size,
+                           const EarlyStoppingOptions &early_stopping) {
     if (X_input.cols() != Y.cols()) {
         throw std::runtime_error(
             "MLP::train, X_input.cols doesn't match the number of Y.cols "
@@ -88,11 +322,35 @@ TrainingResults MLP::train(const Eigen::MatrixXd &X_input, const Eigen::MatrixXd
         );
     }
 
+    // the samples are already in memory, copying a batch is cheap enough to skip the prefetch thread
+    return train(MemoryDataSource(X_input, Y), num_iter, learning_rate, train_proportion, error_list_size,
+                 early_stopping, 256, false);
+}
+
+TrainingResults MLP::train(const DataSource &data,
+                           const int num_iter, const double learning_rate,
+                           double train_proportion, int error_list_size,
+                           const EarlyStoppingOptions &early_stopping,
+                           const int batch_size, const bool prefetch) {
+    if (data.get_input_size() != this->NPL(0) || data.get_output_size() != this->NPL(L)) {
+        throw std::runtime_error(
+            "MLP::train, the data sizes don't match the MLP input and output sizes"
+            "\nGot: " + std::to_string(data.get_input_size()) + " -> " + std::to_string(data.get_output_size()) +
+            "\nExpected: " + std::to_string(this->NPL(0)) + " -> " + std::to_string(this->NPL(L))
+        );
+    }
+
     if (num_iter <= 0) {
         throw std::runtime_error(
             "MLP::train, num_iter must be > 0"
         );
     }
+    if (error_list_size <= 0) {
+        throw std::runtime_error(
+            "MLP::train, error_list_size must be > 0"
+            "\nGot: " + std::to_string(error_list_size)
+        );
+    }
 
     // ===== clamp values =====
     if (error_list_size > num_iter) error_list_size = num_iter;
@@ -100,32 +358,60 @@ TrainingResults MLP::train(const Eigen::MatrixXd &X_input, const Eigen::MatrixXd
     if (train_proportion < 0) train_proportion = 0.0f;
 
     // ===== Split the data =====
-    long total_samples = X_input.cols();
+    long total_samples = data.size();
     long train_count = (long)(total_samples * train_proportion);
     long test_count = total_samples - train_count;
 
+    if (train_count <= 0) {
+        throw std::runtime_error(
+            "MLP::train, no training sample (empty data or train_proportion too low)"
+        );
+    }
+
+    // ===== sample weights =====
+    // a sample of weight w counts as w copies of it. The batches draw it in proportion to w^0.5 (the rare
+    // states aren't drowned by the frequent ones) and scale its step by a bounded importance weight that
+    // restores the w copies on average (see BatchLoader), the test error is weighted by w
+    const double* sample_weights = data.get_weights();
+
+    // the weights change at every step, the sparse kernels are rebuilt at the end
+    sparse_weights.clear();
+
     // ==== create random index ======
-    std::vector<int> indices(total_samples);
+    std::vector<long> indices(total_samples);
     std::iota(indices.begin(), indices.end(), 0);
     std::random_device rd;
     std::mt19937 g(rd());
     std::shuffle(indices.begin(), indices.end(), g);
 
-    // ==== create sub-matrix and associated Y =====
-    Eigen::MatrixXd X_train(X_input.rows(), train_count);
-    Eigen::MatrixXd Y_train(Y.rows(), train_count);
-    Eigen::MatrixXd X_test(X_input.rows(), test_count);
-    Eigen::MatrixXd Y_test(Y.rows(), test_count);
-
-    for(long i = 0; i < total_samples; i++) {
-        if(i < train_count) {
-            X_train.col(i) = X_input.col(indices[i]);
-            Y_train.col(i) = Y.col(indices[i]);
-        } else {
-            X_test.col(i - train_count) = X_input.col(indices[i]);
-            Y_test.col(i - train_count) = Y.col(indices[i]);
+    // the split is kept as indices into the data, samples are only pulled by batches
+    // (the dataset is never copied, several trainings can share the same read-only data)
+    const std::vector<long> test_indices(indices.begin() + train_count, indices.end());
+    indices.resize(train_count);
+
+    double test_weight_sum = static_cast<double>(test_count);
+    if (sample_weights != nullptr) {
+        if (std::any_of(sample_weights, sample_weights + total_samples, [](const double w) { return !(w >= 0.0); })) {
+            throw std::runtime_error("MLP::train, the sample weights must be >= 0");
         }
+
+        double train_weight_sum = 0.0;
+        for (const long index : indices) train_weight_sum += sample_weights[index];
+        if (train_weight_sum <= 0.0) {
+            throw std::runtime_error("MLP::train, the training samples all have a weight of 0");
+        }
+
+        test_weight_sum = 0.0;
+        for (const long index : test_indices) test_weight_sum += sample_weights[index];
     }
+    BatchLoader train_batches(data, std::move(indices), batch_size, prefetch, g());
+    const Batch* batch = nullptr;
+    Eigen::Index batch_pos = 0;
+
+    Eigen::MatrixXd X_test_batch;
+    Eigen::MatrixXd Y_test_batch;
+    std::vector<long> test_batch_indices;
+    test_batch_indices.reserve(batch_size);
 
     // setup other variables
     Eigen::VectorXd train_error_list = Eigen::VectorXd::Zero(error_list_size);
@@ -136,35 +422,47 @@ TrainingResults MLP::train(const Eigen::MatrixXd &X_input, const Eigen::MatrixXd
     int modulo = num_iter / error_list_size;
     if (modulo == 0) modulo = 1;
 
-    // One vector without bias, one with bias for updates
-    Eigen::VectorXd X_k(X_input.rows());
-    Eigen::VectorXd Y_k_bias = Eigen::VectorXd::Ones(Y.rows() + 1);
+    // ===== best weights tracking =====
+    // the test error is monitored (train error when there is no test set). Two snapshot buffers so
+    // a new best can be stored while the background writer is still saving the previous one
+    const bool checkpointing = !early_stopping.checkpoint_path.empty() && early_stopping.checkpoint_every > 0;
+    const bool track_best = early_stopping.patience > 0 || checkpointing;
 
-    for (int i = 0; i < num_iter; i++) {
-        const int randomIndex = rand() % train_count;
+    std::array<std::vector<Eigen::MatrixXd>, 2> snapshots;
+    int best_slot = 0;
+    int writer_slot = -1;
+    bool best_unsaved = false;
+    std::future<void> checkpoint_writer;
 
-        X_k = X_train.col(randomIndex); // get a random example
+    double best_error = std::numeric_limits<double>::infinity();
+    int best_error_index = -1;
+    int evaluations_since_best = 0;
+    bool stopped_early = false;
 
-        Y_k_bias.tail(Y.rows()) = Y_train.col(randomIndex);
+    // One vector without bias, one with bias for updates
+    Eigen::VectorXd X_k(data.get_input_size());
+    Eigen::VectorXd Y_k_bias = Eigen::VectorXd::Ones(data.get_output_size() + 1);
 
-        propagate(X_k);
+    for (int i = 0; i < num_iter; i++) {
+        if (batch == nullptr || batch_pos == batch->X.cols()) {
+            batch = &train_batches.next(); // already random samples
+            batch_pos = 0;
+        }
 
-        deltas[L] = this->X[L] - Y_k_bias;
+        X_k = batch->X.col(batch_pos); // get a random example
 
-        MSE_cumul += deltas[L].array().square().mean();
+        Y_k_bias.tail(Y_k_bias.size() - 1) = batch->Y.col(batch_pos);
+        const double step_weight = batch->step_weights.empty() ? 1.0 : batch->step_weights[batch_pos];
+        batch_pos++;
 
-        if (this->isClassification) {
-            deltas[L] = deltas[L].array() * (1.0 - this->X[L].array().square()).array();
-        }
+        propagate(X_k);
 
-        // get the deltas
-        for (int l = L; l >= 2; l--) {
-            deltas[l-1] = (1.0 - this->X[l-1].array().square()).matrix().cwiseProduct(weights[l] * deltas[l]); // (1 - X[l-1]**2) * (W[l] @ deltas[l])
-        }
+        MSE_cumul += step_weight * backpropagate(Y_k_bias);
 
         // update the weights
         for (int l = 1; l <= L; l++) {
-            weights[l] -= learning_rate * (this->X[l-1] * deltas[l].transpose());
+            weights[l] -= (learning_rate * step_weight) * (this->X[l-1] * deltas[l].transpose());
+            if (!masks.empty()) weights[l].array() *= masks[l].array(); // pruned weights stay at 0
         }
 
         // get the error
@@ -175,30 +473,109 @@ TrainingResults MLP::train(const Eigen::MatrixXd &X_input, const Eigen::MatrixXd
             // update the test error
             if (test_count > 0) {
                 double MSE_cumul_test = 0.0;
-                // We iterate over the test set to get an accurate metric
-                for(int t = 0; t < test_count; t++) {
-                    Eigen::VectorXd X_test_sample = X_test.col(t);
-                    Eigen::VectorXd Y_test_target = Eigen::VectorXd::Ones(Y.rows() + 1);
-                    Y_test_target.tail(Y.rows()) = Y_test.col(t);
-
-                    propagate(X_test_sample);
-
-                    Eigen::VectorXd diff = this->X[L] - Y_test_target;
-                    MSE_cumul_test += diff.array().square().mean();
+                // We iterate over the test set to get an accurate metric, one batch at a time
+                Eigen::VectorXd Y_test_target = Eigen::VectorXd::Ones(data.get_output_size() + 1);
+                for (long start = 0; start < test_count; start += batch_size) {
+                    const long end = std::min<long>(start + batch_size, test_count);
+                    test_batch_indices.assign(test_indices.begin() + start, test_indices.begin() + end);
+                    data.fetch(test_batch_indices, X_test_batch, Y_test_batch);
+
+                    for (Eigen::Index t = 0; t < X_test_batch.cols(); t++) {
+                        Y_test_target.tail(Y_test_batch.rows()) = Y_test_batch.col(t);
+
+                        propagate(X_test_batch.col(t));
+
+                        Eigen::VectorXd diff = this->X[L] - Y_test_target;
+                        const double test_weight = sample_weights != nullptr ? sample_weights[test_batch_indices[t]] : 1.0;
+                        MSE_cumul_test += test_weight * diff.array().square().mean();
+                    }
                 }
-                test_error_list(error_idx) = MSE_cumul_test / test_count;
+                test_error_list(error_idx) = test_weight_sum > 0.0 ? MSE_cumul_test / test_weight_sum : 0.0;
             } else {
                 test_error_list(error_idx) = 0.0;
             }
 
+            if (track_best) {
+                const double monitored = test_count > 0 ? test_error_list(error_idx) : train_error_list(error_idx);
+
+                if (monitored < best_error) {
+                    best_error = monitored;
+                    best_error_index = error_idx;
+                    evaluations_since_best = 0;
+
+                    // only wait for the writer if it is still reading the buffer we need
+                    const int target = 1 - best_slot;
+                    if (checkpoint_writer.valid() && writer_slot == target) checkpoint_writer.get();
+
+                    snapshots[target] = weights;
+                    best_slot = target;
+                    best_unsaved = true;
+                } else {
+                    evaluations_since_best++;
+                }
+
+                // skip this checkpoint if the previous write isn't done, the next one will catch up
+                const bool writer_busy = checkpoint_writer.valid() &&
+                    checkpoint_writer.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+                if (checkpointing && best_unsaved && !writer_busy && (error_idx + 1) % early_stopping.checkpoint_every == 0) {
+                    if (checkpoint_writer.valid()) checkpoint_writer.get();
+
+                    writer_slot = best_slot;
+                    best_unsaved = false;
+                    checkpoint_writer = std::async(std::launch::async, &MLP::save_weights,
+                                                   early_stopping.checkpoint_path, isClassification,
+                                                   std::cref(NPL), std::cref(snapshots[writer_slot]));
+                }
+
+                if (early_stopping.patience > 0 && evaluations_since_best >= early_stopping.patience) {
+                    stopped_early = true;
+                }
+            }
+
             error_idx++;
+
+            if (stopped_early) break;
         }
     }
 
-    return {train_error_list, test_error_list};
+    // ===== finish the checkpoints and restore the best weights =====
+    if (checkpoint_writer.valid()) checkpoint_writer.get();
+
+    if (track_best && best_error_index >= 0) {
+        if (checkpointing && best_unsaved) {
+            save_weights(early_stopping.checkpoint_path, isClassification, NPL, snapshots[best_slot]);
+        }
+        if (early_stopping.restore_best) {
+            weights = snapshots[best_slot];
+        }
+    }
+
+    if (stopped_early) {
+        train_error_list.conservativeResize(error_idx);
+        test_error_list.conservativeResize(error_idx);
+    }
+
+    update_sparse_kernels();
+
+    return {train_error_list, test_error_list, best_error_index, stopped_early};
+}
+
+TrainingResults MLP::train_distilled(const TeacherOutputs &teacher, const DataSource &data,
+                                     const double teacher_weight,
+                                     const int num_iter, const double learning_rate,
+                                     const double train_proportion, const int error_list_size,
+                                     const EarlyStoppingOptions &early_stopping,
+                                     const int batch_size, const bool prefetch) {
+    return train(DistillationDataSource(data, teacher, teacher_weight), num_iter, learning_rate, train_proportion,
+                 error_list_size, early_stopping, batch_size, prefetch);
 }
 
 void MLP::save(const std::string &filepath) const {
+    save_weights(filepath, isClassification, NPL, weights);
+}
+
+void MLP::save_weights(const std::string &filepath, const bool isClassification,
+                       const Eigen::VectorXi &NPL, const std::vector<Eigen::MatrixXd> &weights) {
     std::ofstream out(filepath, std::ios::binary | std::ios::trunc); // Add trunc to force overwrite
     if (!out.is_open()) {
         throw std::runtime_error("Cannot open file for writing: " + filepath);
@@ -211,7 +588,7 @@ void MLP::save(const std::string &filepath) const {
     out.write(reinterpret_cast<const char*>(NPL.data()), NPL.size() * sizeof(int));
 
     // loop through all layers l=1 to L
-    for (int l = 1; l <= L; l++) {
+    for (int l = 1; l < layers_count; l++) {
         const auto &w = weights[l];
         // write data to the file
         out.write(reinterpret_cast<const char*>(w.data()), w.size() * sizeof(double));
@@ -220,6 +597,41 @@ void MLP::save(const std::string &filepath) const {
     out.close();
 }
 
+void MLP::save_sparse(const std::string &filepath) const {
+    std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + filepath);
+    }
+
+    // "SNKS", int32 version, then the same header as save,
+    // then per layer: int64 non zero count, int32 column-major indices, double values
+    out.write(SPARSE_MAGIC, sizeof(SPARSE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&SPARSE_VERSION), sizeof(int32_t));
+    out.write(reinterpret_cast<const char*>(&isClassification), sizeof(bool));
+
+    int layers_count = NPL.size();
+    out.write(reinterpret_cast<const char*>(&layers_count), sizeof(int));
+    out.write(reinterpret_cast<const char*>(NPL.data()), NPL.size() * sizeof(int));
+
+    for (int l = 1; l < layers_count; l++) {
+        std::vector<int32_t> indices;
+        std::vector<double> values;
+        for (long k = 0; k < weights[l].size(); k++) {
+            if (weights[l].data()[k] != 0.0) {
+                indices.push_back(static_cast<int32_t>(k));
+                values.push_back(weights[l].data()[k]);
+            }
+        }
+
+        const auto count = static_cast<int64_t>(indices.size());
+        out.write(reinterpret_cast<const char*>(&count), sizeof(int64_t));
+        out.write(reinterpret_cast<const char*>(indices.data()), count * sizeof(int32_t));
+        out.write(reinterpret_cast<const char*>(values.data()), count * sizeof(double));
+    }
+
+    out.close();
+}
+
 void MLP::load(const std::string &filepath) {
     std::ifstream in(filepath, std::ios::binary);
     if (!in.is_open()) {
@@ -227,7 +639,20 @@ void MLP::load(const std::string &filepath) {
     }
 
     //Read Header
-    in.read(reinterpret_cast<char*>(&isClassification), sizeof(bool));
+    char magic[sizeof(SPARSE_MAGIC)] = {};
+    in.read(magic, 1);
+    const bool sparse = magic[0] == SPARSE_MAGIC[0];
+    if (sparse) {
+        int32_t version = 0;
+        in.read(magic + 1, sizeof(SPARSE_MAGIC) - 1);
+        in.read(reinterpret_cast<char*>(&version), sizeof(int32_t));
+        if (std::memcmp(magic, SPARSE_MAGIC, sizeof(SPARSE_MAGIC)) != 0 || version != SPARSE_VERSION) {
+            throw std::runtime_error("Unknown sparse model format: " + filepath);
+        }
+        in.read(reinterpret_cast<char*>(&isClassification), sizeof(bool));
+    } else {
+        isClassification = magic[0] != 0;
+    }
 
     int layers_count = 0;
     in.read(reinterpret_cast<char*>(&layers_count), sizeof(int));
@@ -262,9 +687,36 @@ void MLP::load(const std::string &filepath) {
             this->weights[l] = Eigen::MatrixXd::Zero(rows, cols);
 
             // Read data
-            in.read(reinterpret_cast<char*>(this->weights[l].data()), rows * cols * sizeof(double));
+            if (!sparse) {
+                in.read(reinterpret_cast<char*>(this->weights[l].data()), rows * cols * sizeof(double));
+                continue;
+            }
+
+            int64_t count = 0;
+            in.read(reinterpret_cast<char*>(&count), sizeof(int64_t));
+            if (count < 0 || count > static_cast<int64_t>(rows) * cols) {
+                throw std::runtime_error("Corrupted sparse model file: " + filepath);
+            }
+            std::vector<int32_t> indices(count);
+            std::vector<double> values(count);
+            in.read(reinterpret_cast<char*>(indices.data()), count * sizeof(int32_t));
+            in.read(reinterpret_cast<char*>(values.data()), count * sizeof(double));
+            for (int64_t k = 0; k < count; k++) {
+                if (indices[k] < 0 || indices[k] >= rows * cols) {
+                    throw std::runtime_error("Corrupted sparse model file: " + filepath);
+                }
+                this->weights[l].data()[indices[k]] = values[k];
+            }
         }
     }
 
     in.close();
+
+    // a sparse model keeps its zeros if it is trained again
+    masks.clear();
+    if (sparse) {
+        masks.resize(L + 1);
+        for (int l = 1; l <= L; l++) masks[l] = (weights[l].array() != 0.0).cast<double>().matrix();
+    }
+    update_sparse_kernels();
 }
@@ -9,9 +9,31 @@
 #include <fstream>
 #include <string>
 
+#include "BlockSparseMatrix.hpp"
+#include "InferenceStats.hpp"
+
+class DataSource;
+class TeacherOutputs;
+
 struct TrainingResults {
-    Eigen::VectorXd train_errors;
+    Eigen::VectorXd train_errors; // shortened to the evaluations actually done when stopped early
     Eigen::VectorXd test_errors;
+    int best_error_index = -1; // evaluation with the lowest monitored error, -1 if not tracked
+    bool stopped_early = false;
+};
+
+struct EarlyStoppingOptions {
+    int patience = 0; // error evaluations without improvement before stopping, 0 = run all num_iter
+    bool restore_best = true; // end the training with the best weights instead of the last ones
+    std::string checkpoint_path; // best weights written there in the background, empty = no checkpoint
+    int checkpoint_every = 0; // in error evaluations
+};
+
+struct PruningOptions {
+    double sparsity = 0.5; // share of the hidden layer weights set to 0 (the output layer and col(0) are kept)
+    bool per_layer = false; // same sparsity in every layer instead of one magnitude threshold for the whole net
+    bool structured = false; // prune whole blocks of BlockSparseMatrix::BLOCK_ROWS weights (by L2 norm), faster kernel
+    double min_layer_density = 0.05; // share of each layer always kept, lowers the sparsity when needed
 };
 
 class MLP {
@@ -21,16 +43,30 @@ class MLP {
     std::vector<Eigen::MatrixXd> weights;
     std::vector<Eigen::VectorXd> X;
     std::vector<Eigen::VectorXd> deltas;
+    std::vector<Eigen::MatrixXd> masks; // 0/1 per weight after prune, kept during train (empty = no mask)
+    std::vector<BlockSparseMatrix> sparse_weights; // layers sparse enough for the sparse kernel (others empty)
+    LazyInferenceStats stats; // filled by the C API calls
 
     void propagate(const Eigen::VectorXd& X_input);
+    double backpropagate(const Eigen::VectorXd& Y_bias); // fills deltas after propagate, returns the sample MSE
+
+    void update_sparse_kernels(); // after any change of the weights
+
+    static void save_weights(const std::string &filepath, bool isClassification,
+                             const Eigen::VectorXi &NPL, const std::vector<Eigen::MatrixXd> &weights);
 
 public:
     explicit MLP(const Eigen::VectorXi &NPL, bool isClassification = true);
     ~MLP() = default;
+    MLP(const MLP&) = default; // the copy starts without inference stats
+    MLP& operator=(const MLP&) = default;
+    MLP(MLP&&) = default;
+    MLP& operator=(MLP&&) = default;
 
     [[nodiscard]] const Eigen::VectorXi* get_neuron_per_layer() const;
     [[nodiscard]] int get_input_size() const;
     [[nodiscard]] int get_output_size() const;
+    [[nodiscard]] bool is_classification() const;
     [[nodiscard]] const std::vector<Eigen::MatrixXd>* get_weights() const;
     [[nodiscard]] const std::vector<Eigen::VectorXd>* get_X() const {
         return &X;
@@ -39,15 +75,57 @@ public:
         return &deltas;
     }
 
+    [[nodiscard]] const InferenceStats& get_stats() const {
+        return stats.get();
+    }
+    [[nodiscard]] InferenceStats& record_stats() {
+        return stats.for_recording();
+    }
+    void reset_stats() {
+        stats.reset();
+    }
+
+    void set_weights(const std::vector<Eigen::MatrixXd>& new_weights); // same shapes as get_weights, clears the mask
+
+    // gradient of 0.5 * ||X[L] - Y_bias||^2 for each weight matrix (index 0 left empty), as used by train
+    [[nodiscard]] std::vector<Eigen::MatrixXd> gradients(const Eigen::VectorXd& X_input, const Eigen::VectorXd& Y);
+
+    // zero the smallest hidden layer weights, the mask is kept so a following train fine-tunes only the
+    // remaining ones. Throws for a model without a hidden layer
+    void prune(const PruningOptions& options);
+    void clear_mask();
+    [[nodiscard]] double get_density() const; // share of non zero weights, col(0) (bias neuron) excluded
+    [[nodiscard]] int sparse_layer_count() const; // layers currently using the sparse kernel
+
     void save(const std::string &filepath) const;
+    // only the non zero weights, smaller for pruned models. load reads both formats
+    void save_sparse(const std::string &filepath) const;
     void load(const std::string &filepath);
 
     [[nodiscard]] Eigen::VectorXd predict(const Eigen::VectorXd& X_input);
-    [[nodiscard]] Eigen::MatrixXd predict(const Eigen::MatrixXd& X_input);
+    // one sample per column, computed layer by layer for the whole batch (doesn't touch the per-sample buffers)
+    [[nodiscard]] Eigen::MatrixXd predict_batch(const Eigen::MatrixXd& X_input) const;
 
     [[nodiscard]] TrainingResults train(const Eigen::MatrixXd& X_input, const Eigen::MatrixXd& Y,
                                     int num_iter, double learning_rate,
-                                    double train_proportion, int error_list_size);
+                                    double train_proportion, int error_list_size,
+                                    const EarlyStoppingOptions& early_stopping = {});
+    // samples pulled from the source by batches of batch_size, decoded on another thread with prefetch.
+    // When the source has sample weights, samples are drawn in proportion to weight^0.5 and each step is
+    // scaled by a bounded importance weight, so the expected update stays the full data one
+    [[nodiscard]] TrainingResults train(const DataSource& data,
+                                    int num_iter, double learning_rate,
+                                    double train_proportion, int error_list_size,
+                                    const EarlyStoppingOptions& early_stopping = {},
+                                    int batch_size = 256, bool prefetch = true);
+    // knowledge distillation: trained toward the cached teacher outputs on the same data, mixed with
+    // the recorded targets when teacher_weight < 1 (the reported errors are against these mixed targets)
+    [[nodiscard]] TrainingResults train_distilled(const TeacherOutputs& teacher, const DataSource& data,
+                                    double teacher_weight,
+                                    int num_iter, double learning_rate,
+                                    double train_proportion, int error_list_size,
+                                    const EarlyStoppingOptions& early_stopping = {},
+                                    int batch_size = 256, bool prefetch = true);
 };
 
 
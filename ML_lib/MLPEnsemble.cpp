@@ -0,0 +1,130 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "MLPEnsemble.hpp"
+
+#include <stdexcept>
+#include <string>
+
+MLPEnsemble::MLPEnsemble(const std::vector<const MLP*>& models) {
+    if (models.empty()) {
+        throw std::runtime_error("MLPEnsemble, at least one model is required");
+    }
+
+    this->input_size = models[0]->get_input_size();
+    this->output_size = models[0]->get_output_size();
+    this->model_count = static_cast<int>(models.size());
+
+    // ensure that all the members can share the same input and be combined
+    long first_cols = 0;
+    for (const MLP* model : models) {
+        if (model->get_input_size() != input_size || model->get_output_size() != output_size) {
+            throw std::runtime_error(
+                "MLPEnsemble, all models must share the same input and output size"
+                "\nExpected: " + std::to_string(input_size) + " -> " + std::to_string(output_size) +
+                "\nGot: " + std::to_string(model->get_input_size()) + " -> " + std::to_string(model->get_output_size())
+            );
+        }
+        first_cols += (*model->get_weights())[1].cols();
+    }
+
+    // concatenate the first layer weights of every member
+    this->first_layer = Eigen::MatrixXd(input_size + 1, first_cols);
+    this->first_offsets.reserve(model_count);
+    this->tail_weights.reserve(model_count);
+    this->classification.reserve(model_count);
+
+    long offset = 0;
+    for (const MLP* model : models) {
+        const std::vector<Eigen::MatrixXd>& W = *model->get_weights();
+
+        first_layer.middleCols(offset, W[1].cols()) = W[1];
+        first_offsets.push_back(offset);
+        offset += W[1].cols();
+
+        tail_weights.emplace_back(W.begin() + 2, W.end());
+        classification.push_back(model->is_classification());
+    }
+
+    this->X_input = Eigen::VectorXd::Zero(input_size + 1);
+    this->X_input(0) = 1.0; // bias input
+    this->first_signal = Eigen::RowVectorXd::Zero(first_cols);
+}
+
+int MLPEnsemble::get_input_size() const {
+    return input_size;
+}
+
+int MLPEnsemble::get_output_size() const {
+    return output_size;
+}
+
+int MLPEnsemble::get_model_count() const {
+    return model_count;
+}
+
+Eigen::VectorXd MLPEnsemble::forward_member(const int m, const Eigen::VectorXd &first_activation) const {
+    // same rules as MLP::propagate, starting from the already computed layer 1
+    const std::vector<Eigen::MatrixXd>& W = tail_weights[m];
+    const auto L = static_cast<int>(W.size()) + 1;
+
+    Eigen::VectorXd X_l = first_activation;
+    for (int l = 2; l <= L; l++) {
+        Eigen::VectorXd signal = X_l.transpose() * W[l - 2];
+
+        if (classification[m] || l != L) {
+            X_l = signal.array().tanh();
+        }
+        else {
+            X_l = signal;
+        }
+    }
+
+    return X_l.segment(1, X_l.size() - 1); // output without the bias
+}
+
+Eigen::VectorXd MLPEnsemble::predict(const Eigen::VectorXd &X, const EnsembleMode mode) {
+    if (X.size() != input_size) {
+        throw std::runtime_error(
+            "MLPEnsemble::predict, X.size doesn't match the size of the ensemble input"
+            "\nGot X.size(): " + std::to_string(X.size()) +
+            "\nExpected: " + std::to_string(input_size)
+        );
+    }
+    if (mode != EnsembleMode::Average && mode != EnsembleMode::Vote) {
+        throw std::runtime_error("MLPEnsemble::predict, unknown mode");
+    }
+
+    X_input.tail(input_size) = X;
+
+    // layer 1 of every member in one product
+    first_signal.noalias() = X_input.transpose() * first_layer;
+
+    Eigen::VectorXd result = Eigen::VectorXd::Zero(output_size);
+
+    for (int m = 0; m < model_count; m++) {
+        const long cols = (m + 1 < model_count ? first_offsets[m + 1] : first_layer.cols()) - first_offsets[m];
+        const bool is_output = tail_weights[m].empty();
+
+        Eigen::VectorXd first_activation = first_signal.segment(first_offsets[m], cols).transpose();
+        if (classification[m] || !is_output) {
+            first_activation = first_activation.array().tanh();
+        }
+
+        const Eigen::VectorXd output = is_output
+            ? Eigen::VectorXd(first_activation.segment(1, cols - 1))
+            : forward_member(m, first_activation);
+
+        if (mode == EnsembleMode::Vote) {
+            Eigen::Index best;
+            output.maxCoeff(&best);
+            result(best) += 1.0;
+        }
+        else {
+            result += output;
+        }
+    }
+
+    return result / model_count;
+}
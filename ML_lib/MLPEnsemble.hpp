@@ -0,0 +1,46 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_MLPENSEMBLE_H
+#define ML_LIB_MLPENSEMBLE_H
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include "MLP.hpp"
+
+enum class EnsembleMode {
+    Average = 0, // mean of the members outputs
+    Vote = 1     // share of members whose argmax is each action
+};
+
+class MLPEnsemble {
+    int input_size;
+    int output_size;
+    int model_count;
+
+    // W[1] of every member side by side, so the shared input goes through one wider GEMM
+    Eigen::MatrixXd first_layer;
+    std::vector<long> first_offsets; // column where each member starts in first_layer
+    std::vector<std::vector<Eigen::MatrixXd>> tail_weights; // W[2..L] of each member
+    std::vector<bool> classification;
+
+    Eigen::VectorXd X_input; // shared input buffer, X_input(0) is the bias neuron
+    Eigen::RowVectorXd first_signal;
+
+    [[nodiscard]] Eigen::VectorXd forward_member(int m, const Eigen::VectorXd& first_activation) const;
+
+public:
+    // the weights are copied, training a member afterward is not reflected in the ensemble
+    explicit MLPEnsemble(const std::vector<const MLP*>& models);
+    ~MLPEnsemble() = default;
+
+    [[nodiscard]] int get_input_size() const;
+    [[nodiscard]] int get_output_size() const;
+    [[nodiscard]] int get_model_count() const;
+
+    [[nodiscard]] Eigen::VectorXd predict(const Eigen::VectorXd& X, EnsembleMode mode = EnsembleMode::Average);
+};
+
+#endif //ML_LIB_MLPENSEMBLE_H
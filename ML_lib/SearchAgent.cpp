@@ -0,0 +1,544 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#include "SearchAgent.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // URDL moves as (X, Y) deltas, X grows downward
+    constexpr int MOVE_X[SnakeState::ACTION_COUNT] = {-1, 0, 1, 0};
+    constexpr int MOVE_Y[SnakeState::ACTION_COUNT] = {0, 1, 0, -1};
+
+    // leaf values, the discount makes the same event worth less when it happens later
+    constexpr double DEATH_VALUE = -1000.0;
+    constexpr double APPLE_VALUE = 100.0;
+    constexpr double TRAP_VALUE = -500.0; // scaled by the missing share of the space the body needs
+
+    constexpr int PREDICT_CHUNK = 32; // smallest batch worth a worker
+    constexpr double COST_SMOOTHING = 0.2;
+
+    double elapsed_ms(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// ============= SnakeState ================
+
+SnakeState SnakeState::from_game_state(const int *state, const int size, const int grid_size, const ZobristKeys &keys) {
+    if (grid_size <= 0 || size != input_size(grid_size) + 1) {
+        throw std::runtime_error(
+            "SnakeState::from_game_state, the state size doesn't match the grid"
+            "\nGot: " + std::to_string(size) +
+            "\nExpected: " + std::to_string(input_size(grid_size) + 1)
+        );
+    }
+
+    auto inside = [grid_size](const int x, const int y) {
+        return x >= 0 && x < grid_size && y >= 0 && y < grid_size;
+    };
+
+    SnakeState result;
+    result.grid_size = grid_size;
+
+    const int head_x = state[2];
+    const int head_y = state[5];
+    const int length = state[8];
+    if (length < 1 || length > grid_size * grid_size || !inside(head_x, head_y)) {
+        throw std::runtime_error("SnakeState::from_game_state, invalid snake");
+    }
+
+    for (int i = 0; i < length; i++) {
+        const int x = head_x + state[9 + 2 * i];
+        const int y = head_y + state[9 + 2 * i + 1];
+        if (!inside(x, y)) {
+            throw std::runtime_error("SnakeState::from_game_state, body cell outside the grid");
+        }
+        result.body.push_back(x * grid_size + y);
+    }
+
+    const int apple_x = head_x + state[6];
+    const int apple_y = head_y + state[7];
+    result.apple = inside(apple_x, apple_y) ? apple_x * grid_size + apple_y : -1;
+
+    if (length >= 2) {
+        const int neck = result.body[length - 2];
+        const int dx = head_x - neck / grid_size;
+        const int dy = head_y - neck % grid_size;
+        for (int action = 0; action < ACTION_COUNT; action++) {
+            if (MOVE_X[action] == dx && MOVE_Y[action] == dy) result.direction = action;
+        }
+    }
+
+    result.hash = keys.hash(result);
+    result.body_hash = keys.body_hash(result);
+    return result;
+}
+
+bool SnakeState::is_reverse(const int action) const {
+    return action == (direction + 2) % ACTION_COUNT;
+}
+
+SnakeState::StepResult SnakeState::step(int action, const ZobristKeys &keys) {
+    if (action < 0 || action >= ACTION_COUNT || is_reverse(action)) action = direction;
+
+    const int old_head = head();
+    const int x = old_head / grid_size + MOVE_X[action];
+    const int y = old_head % grid_size + MOVE_Y[action];
+    if (x < 0 || x >= grid_size || y < 0 || y >= grid_size) return StepResult::Died;
+
+    const int next = x * grid_size + y;
+    if (std::find(body.begin(), body.end(), next) != body.end()) return StepResult::Died;
+
+    direction = action;
+    hash ^= keys.head[old_head] ^ keys.body[next] ^ keys.head[next];
+    body_hash = body_hash * ZobristKeys::ORDER_BASE + keys.body[next];
+    body.push_back(next);
+
+    if (next == apple) {
+        hash ^= keys.apple[apple + 1] ^ keys.apple[0];
+        apple = -1;
+        return StepResult::Ate;
+    }
+
+    const int old_tail = body.front();
+    body_hash -= keys.body[old_tail] * keys.order_power[body.size() - 1];
+    body.pop_front();
+    hash ^= keys.body[old_tail] ^ keys.tail[old_tail] ^ keys.tail[body.front()];
+    return StepResult::Moved;
+}
+
+int SnakeState::free_space(const int limit) const {
+    std::vector<char> blocked(grid_size * grid_size, 0);
+    for (size_t i = 1; i < body.size(); i++) blocked[body[i]] = 1; // the tail leaves after the next move
+    blocked[head()] = 1;
+
+    std::vector<int> queue;
+    queue.reserve(blocked.size());
+    queue.push_back(head());
+
+    int reached = 0;
+    for (size_t q = 0; q < queue.size() && reached < limit; q++) {
+        const int cell = queue[q];
+        for (int action = 0; action < ACTION_COUNT; action++) {
+            const int x = cell / grid_size + MOVE_X[action];
+            const int y = cell % grid_size + MOVE_Y[action];
+            if (x < 0 || x >= grid_size || y < 0 || y >= grid_size) continue;
+
+            const int neighbour = x * grid_size + y;
+            if (blocked[neighbour]) continue;
+            if (q == 0 && neighbour == body.front()) continue; // moving into the tail is a death, as in step
+            blocked[neighbour] = 1;
+            queue.push_back(neighbour);
+            reached++;
+        }
+    }
+    return std::min(reached, limit);
+}
+
+void SnakeState::encode(double *out) const {
+    const int head_x = head() / grid_size;
+    const int head_y = head() % grid_size;
+
+    out[0] = static_cast<double>(body.size()) - 2.0; // score
+    out[1] = head_x; // distance to the top
+    out[2] = grid_size - 1 - head_y; // right
+    out[3] = grid_size - 1 - head_x; // bottom
+    out[4] = head_y; // left
+    out[5] = apple >= 0 ? apple / grid_size - head_x : 0;
+    out[6] = apple >= 0 ? apple % grid_size - head_y : 0;
+    out[7] = static_cast<double>(body.size());
+
+    // body relative to the head, tail first, padded with zeros
+    std::fill(out + 8, out + input_size(grid_size), 0.0);
+    double *pair = out + 8;
+    for (const int cell : body) {
+        *pair++ = cell / grid_size - head_x;
+        *pair++ = cell % grid_size - head_y;
+    }
+}
+
+// ============= ZobristKeys ================
+
+ZobristKeys::ZobristKeys(const int grid_size, const uint64_t seed) {
+    std::mt19937_64 g(seed);
+    const int cells = grid_size * grid_size;
+    for (auto *keys : {&body, &head, &tail}) {
+        keys->resize(cells);
+        for (auto &key : *keys) key = g();
+    }
+    apple.resize(cells + 1);
+    for (auto &key : apple) key = g();
+
+    order_power.resize(cells + 1);
+    order_power[0] = 1;
+    for (int i = 1; i <= cells; i++) order_power[i] = order_power[i - 1] * ORDER_BASE;
+}
+
+uint64_t ZobristKeys::hash(const SnakeState &state) const {
+    uint64_t result = head[state.head()] ^ tail[state.body.front()] ^ apple[state.apple + 1];
+    for (const int cell : state.body) result ^= body[cell];
+    return result;
+}
+
+uint64_t ZobristKeys::body_hash(const SnakeState &state) const {
+    uint64_t result = 0;
+    for (const int cell : state.body) result = result * ORDER_BASE + body[cell];
+    return result;
+}
+
+// ============= WorkerPool ================
+
+WorkerPool::WorkerPool(int thread_count) {
+    if (thread_count <= 0) thread_count = static_cast<int>(std::thread::hardware_concurrency());
+    if (thread_count <= 0) thread_count = 1;
+
+    threads.reserve(thread_count - 1);
+    for (int t = 1; t < thread_count; t++) {
+        threads.emplace_back(&WorkerPool::work_loop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) thread.join();
+}
+
+void WorkerPool::drain() {
+    for (int index = next++; index < count; index = next++) {
+        try {
+            (*job)(index);
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+}
+
+void WorkerPool::work_loop() {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return stopping || round != seen; });
+            if (stopping) return;
+            seen = round;
+        }
+
+        drain();
+
+        std::lock_guard lock(mutex);
+        if (--busy == 0) done.notify_one();
+    }
+}
+
+void WorkerPool::run(const int count, const std::function<void(int)> &job) {
+    if (count <= 0) return;
+
+    if (threads.empty() || count == 1) {
+        for (int index = 0; index < count; index++) job(index);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        this->job = &job;
+        this->count = count;
+        next = 0;
+        busy = static_cast<int>(threads.size());
+        round++;
+    }
+    wake.notify_all();
+
+    drain();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return busy == 0; });
+    this->job = nullptr;
+
+    if (error) {
+        std::exception_ptr failure = error;
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+// ============= SearchAgent ================
+
+SearchAgent::SearchAgent(const MLP &model, const int grid_size, const SearchOptions &options)
+    : model(model), grid_size(grid_size), options(options),
+      keys(grid_size), pool(options.thread_count) {
+    if (grid_size <= 0 || model.get_input_size() != SnakeState::input_size(grid_size) ||
+        model.get_output_size() != SnakeState::ACTION_COUNT) {
+        throw std::runtime_error(
+            "SearchAgent, the model doesn't match the game"
+            "\nGot: " + std::to_string(model.get_input_size()) + " -> " + std::to_string(model.get_output_size()) +
+            "\nExpected: " + std::to_string(SnakeState::input_size(std::max(grid_size, 0))) + " -> " +
+            std::to_string(SnakeState::ACTION_COUNT)
+        );
+    }
+    if (options.max_depth <= 0 || options.expanded_moves <= 0 || options.prior_temperature <= 0.0 ||
+        options.table_bits <= 0 || options.table_bits > 30) {
+        throw std::runtime_error("SearchAgent, invalid options");
+    }
+
+    table.resize(size_t{1} << options.table_bits);
+}
+
+std::array<double, SnakeState::ACTION_COUNT> SearchAgent::to_priors(const Eigen::VectorXd &outputs) const {
+    std::array<double, SnakeState::ACTION_COUNT> priors{};
+    const double highest = outputs.maxCoeff();
+    double total = 0.0;
+    for (int action = 0; action < SnakeState::ACTION_COUNT; action++) {
+        priors[action] = std::exp((outputs(action) - highest) / options.prior_temperature);
+        total += priors[action];
+    }
+    for (double &prior : priors) prior /= total;
+    return priors;
+}
+
+void SearchAgent::evaluate(const std::vector<int> &new_nodes, SearchStats &stats, double &predict_ms) {
+    const size_t mask = table.size() - 1;
+
+    // ===== transpositions and cached priors (single threaded, the table isn't locked) =====
+    std::vector<int> missing;
+    for (const int index : new_nodes) {
+        Node &node = nodes[index];
+        if (node.result == SnakeState::StepResult::Died) continue;
+
+        TableEntry &entry = table[node.state.hash & mask];
+        if (matches(entry, node.state) && entry.search == search_count && entry.node >= 0) {
+            node.transposition = true;
+            stats.table_hits++;
+            continue;
+        }
+        if (!matches(entry, node.state)) {
+            entry.key = node.state.hash;
+            entry.body_hash = node.state.body_hash;
+            entry.length = static_cast<int>(node.state.body.size());
+            entry.has_priors = false;
+        }
+        entry.search = search_count;
+        entry.node = index;
+
+        if (node.result == SnakeState::StepResult::Ate) continue; // not expanded, no prior needed
+
+        if (entry.has_priors) {
+            std::copy(entry.priors.begin(), entry.priors.end(), node.priors.begin());
+            stats.table_hits++;
+        } else {
+            missing.push_back(index);
+        }
+    }
+
+    // ===== one batched forward pass for the rest, split over the workers =====
+    predict_ms = 0.0;
+    if (!missing.empty()) {
+        const auto predict_start = std::chrono::steady_clock::now();
+        const auto count = static_cast<int>(missing.size());
+        const int input_size = SnakeState::input_size(grid_size);
+
+        Eigen::MatrixXd inputs(input_size, count);
+        pool.run(count, [&](const int j) {
+            nodes[missing[j]].state.encode(inputs.col(j).data());
+        });
+
+        Eigen::MatrixXd outputs(SnakeState::ACTION_COUNT, count);
+        const int chunks = std::clamp((count + PREDICT_CHUNK - 1) / PREDICT_CHUNK, 1, pool.size());
+        const int chunk_size = (count + chunks - 1) / chunks;
+        pool.run(chunks, [&](const int c) {
+            const int begin = c * chunk_size;
+            const int size = std::min(chunk_size, count - begin);
+            if (size > 0) outputs.middleCols(begin, size) = model.predict_batch(Eigen::MatrixXd(inputs.middleCols(begin, size)));
+        });
+        stats.evaluated += count;
+        predict_ms = elapsed_ms(predict_start);
+
+        for (int j = 0; j < count; j++) {
+            Node &node = nodes[missing[j]];
+            node.priors = to_priors(outputs.col(j));
+
+            TableEntry &entry = table[node.state.hash & mask];
+            if (matches(entry, node.state)) {
+                std::copy(node.priors.begin(), node.priors.end(), entry.priors.begin());
+                entry.has_priors = true;
+            }
+        }
+    }
+
+    // ===== leaf values =====
+    pool.run(static_cast<int>(new_nodes.size()), [&](const int j) {
+        Node &node = nodes[new_nodes[j]];
+        if (node.result == SnakeState::StepResult::Died) return;
+
+        const auto length = static_cast<int>(node.state.body.size());
+        const int space = node.state.free_space(length);
+        node.estimate = space < length ? TRAP_VALUE * (1.0 - static_cast<double>(space) / length) : 0.0;
+    });
+}
+
+void SearchAgent::back_up() {
+    // children always come after their parent
+    for (auto index = static_cast<int>(nodes.size()) - 1; index >= 0; index--) {
+        Node &node = nodes[index];
+
+        double reward = 0.0;
+        if (node.result == SnakeState::StepResult::Died) reward = DEATH_VALUE;
+        if (node.result == SnakeState::StepResult::Ate) reward = APPLE_VALUE;
+
+        double future = node.estimate;
+        if (node.result != SnakeState::StepResult::Died) {
+            double best_child = -std::numeric_limits<double>::infinity();
+            for (const int child : node.children) {
+                if (child >= 0) best_child = std::max(best_child, nodes[child].value);
+            }
+            if (best_child > -std::numeric_limits<double>::infinity()) future = options.discount * best_child;
+        } else {
+            future = 0.0;
+        }
+
+        node.value = reward + future;
+    }
+}
+
+int SearchAgent::choose_action(const int *state, const int size, SearchStats *stats) {
+    return choose_action(SnakeState::from_game_state(state, size, grid_size, keys), stats);
+}
+
+int SearchAgent::choose_action(const SnakeState &root, SearchStats *stats) {
+    const auto start = std::chrono::steady_clock::now();
+
+    if (root.grid_size != grid_size || root.body.empty()) {
+        throw std::runtime_error("SearchAgent::choose_action, the state doesn't match the grid");
+    }
+
+    search_count++;
+    SearchStats local_stats;
+
+    nodes.clear();
+    nodes.emplace_back();
+    nodes[0].state = root;
+    double predict_ms = 0.0;
+    evaluate({0}, local_stats, predict_ms);
+    nodes[0].transposition = false; // the root is always expanded
+
+    std::vector<int> frontier = {0};
+    std::vector<std::pair<int, int>> moves; // (parent, action)
+    std::vector<int> new_nodes;
+
+    for (int depth = 1; depth <= options.max_depth && !frontier.empty(); depth++) {
+        const double iteration_start = elapsed_ms(start);
+        const long evaluated_before = local_stats.evaluated;
+
+        // ===== pick the moves to expand: all at the root, the best safe ones by prior below =====
+        moves.clear();
+        for (const int index : frontier) {
+            const Node &node = nodes[index];
+            if (node.result != SnakeState::StepResult::Moved || node.transposition) continue;
+
+            std::array<int, SnakeState::ACTION_COUNT> order{};
+            int legal = 0;
+            for (int action = 0; action < SnakeState::ACTION_COUNT; action++) {
+                if (!node.state.is_reverse(action)) order[legal++] = action;
+            }
+            std::stable_sort(order.begin(), order.begin() + legal, [&](const int a, const int b) {
+                return node.priors[a] > node.priors[b];
+            });
+
+            if (index == 0) {
+                for (int k = 0; k < legal; k++) moves.emplace_back(index, order[k]);
+                continue;
+            }
+
+            int expanded = 0;
+            int first_deadly = -1;
+            for (int k = 0; k < legal && expanded < options.expanded_moves; k++) {
+                SnakeState next = node.state;
+                if (next.step(order[k], keys) == SnakeState::StepResult::Died) {
+                    if (first_deadly < 0) first_deadly = order[k];
+                    continue;
+                }
+                moves.emplace_back(index, order[k]);
+                expanded++;
+            }
+            if (expanded == 0 && first_deadly >= 0) moves.emplace_back(index, first_deadly); // nowhere to go
+        }
+        if (moves.empty()) break;
+
+        // ===== play them =====
+        const auto first = static_cast<int>(nodes.size());
+        nodes.resize(nodes.size() + moves.size());
+        pool.run(static_cast<int>(moves.size()), [&](const int m) {
+            const auto [parent, action] = moves[m];
+            Node &child = nodes[first + m];
+            child.state = nodes[parent].state;
+            child.result = child.state.step(action, keys);
+            child.parent = parent;
+            child.action = action;
+            child.depth = depth;
+        });
+
+        new_nodes.resize(moves.size());
+        for (int m = 0; m < static_cast<int>(moves.size()); m++) {
+            nodes[moves[m].first].children[moves[m].second] = first + m;
+            new_nodes[m] = first + m;
+        }
+
+        evaluate(new_nodes, local_stats, predict_ms);
+        back_up();
+        local_stats.depth = depth;
+
+        frontier = new_nodes;
+
+        // ===== does the next depth fit? =====
+        // priced as if none of its states were in the table: a new apple makes them all miss at once
+        const double iteration_ms = elapsed_ms(start) - iteration_start;
+        const long evaluated = local_stats.evaluated - evaluated_before;
+        const double move_ms = (iteration_ms - predict_ms) / static_cast<double>(moves.size());
+        move_cost_ms += COST_SMOOTHING * (move_ms - move_cost_ms);
+        if (evaluated > 0) {
+            sample_cost_ms += COST_SMOOTHING * (predict_ms / static_cast<double>(evaluated) - sample_cost_ms);
+        }
+
+        long next_moves = 0;
+        for (const int index : new_nodes) {
+            if (nodes[index].result == SnakeState::StepResult::Moved && !nodes[index].transposition) {
+                next_moves += options.expanded_moves;
+            }
+        }
+        const double next_ms = static_cast<double>(next_moves) * (move_cost_ms + sample_cost_ms);
+        if (elapsed_ms(start) + next_ms > options.time_budget_ms) break;
+    }
+
+    // ===== best root move, the prior decides between moves of the same value =====
+    const Node &node = nodes[0];
+    int best_action = node.state.direction;
+    double best_score = -std::numeric_limits<double>::infinity();
+    for (int action = 0; action < SnakeState::ACTION_COUNT; action++) {
+        const int child = node.children[action];
+        if (child < 0) continue;
+
+        const double score = nodes[child].value + options.prior_weight * node.priors[action];
+        if (score > best_score) {
+            best_score = score;
+            best_action = action;
+        }
+    }
+
+    local_stats.nodes = static_cast<long>(nodes.size());
+    local_stats.elapsed_us = elapsed_ms(start) * 1000.0;
+    if (stats != nullptr) *stats = local_stats;
+
+    return best_action;
+}
@@ -0,0 +1,193 @@
+//
+// Created by maxim on 19/10/2026.
+//
+
+#ifndef ML_LIB_SEARCHAGENT_H
+#define ML_LIB_SEARCHAGENT_H
+
+#include <Eigen/Dense>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MLP.hpp"
+
+class ZobristKeys;
+
+// The Game.cs rules. Cells are X * grid_size + Y (X grows downward, Y to the right, as in Game.cs)
+class SnakeState {
+public:
+    static constexpr int ACTION_COUNT = 4; // URDL, the order of the game actions
+
+    enum class StepResult {Moved, Ate, Died};
+
+    int grid_size = 16;
+    std::deque<int> body; // tail first, head last (the Game.cs queue order)
+    int apple = -1; // -1 once eaten: the next one is random
+    int direction = 1; // last move (right at the start), the game keeps it when the action is a reverse
+    uint64_t hash = 0; // Zobrist hash, kept up to date by step
+    uint64_t body_hash = 0; // ordered body (polynomial over the cell keys, tail first), checks the Zobrist hits
+
+    // from the Game.GetState vector (game over flag included), direction taken from the neck to the head
+    static SnakeState from_game_state(const int* state, int size, int grid_size, const ZobristKeys& keys);
+
+    [[nodiscard]] int head() const {
+        return body.back();
+    }
+    [[nodiscard]] static int input_size(const int grid_size) {
+        return 2 * grid_size * grid_size + 8;
+    }
+    [[nodiscard]] bool is_reverse(int action) const;
+
+    // Game.DoAction: an action < 0 or a reverse keeps the last direction. Moving out of the grid or
+    // onto the body (the tail included, it only leaves after the move) is a death and leaves the state unchanged
+    StepResult step(int action, const ZobristKeys& keys);
+
+    // cells reachable from the head, the flood fill stops at limit. The tail is only free after the first
+    // move (step kills a snake moving into its tail, it leaves after the move)
+    [[nodiscard]] int free_space(int limit) const;
+
+    // MLP input: the Game.GetState vector without the game over flag
+    void encode(double* out) const;
+};
+
+// Random keys for the body cells, the head, the tail and the apple. The Zobrist hash is the set of body
+// cells: two snakes on the same cells in another order share it, body_hash tells them apart
+class ZobristKeys {
+    static constexpr uint64_t ORDER_BASE = 0x9E3779B97F4A7C15ULL; // odd, invertible modulo 2^64
+
+    std::vector<uint64_t> body;
+    std::vector<uint64_t> head;
+    std::vector<uint64_t> tail;
+    std::vector<uint64_t> apple; // index apple + 1, 0 = no apple
+    std::vector<uint64_t> order_power; // ORDER_BASE^i, to drop the tail from body_hash
+
+    friend class SnakeState;
+
+public:
+    explicit ZobristKeys(int grid_size, uint64_t seed = 0x5EED);
+
+    [[nodiscard]] uint64_t hash(const SnakeState& state) const;
+    [[nodiscard]] uint64_t body_hash(const SnakeState& state) const;
+};
+
+// Persistent threads, run() hands out the indices to them and to the caller and returns when all are done
+class WorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int)>* job = nullptr;
+    int count = 0;
+    std::atomic<int> next{0};
+    int busy = 0;
+    uint64_t round = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void drain();
+    void work_loop();
+
+public:
+    explicit WorkerPool(int thread_count); // 0 = one per hardware thread
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    [[nodiscard]] int size() const {
+        return static_cast<int>(threads.size()) + 1;
+    }
+
+    void run(int count, const std::function<void(int)>& job);
+};
+
+struct SearchOptions {
+    int max_depth = 8; // in moves
+    double time_budget_ms = 5.0; // per choose_action call, no new depth is started when it wouldn't fit
+    int thread_count = 0; // 0 = one per hardware thread
+    int expanded_moves = 2; // moves expanded below the root, the ones with the highest prior
+    double prior_temperature = 0.25; // softmax over the MLP outputs
+    double prior_weight = 1.0; // added to the root move values, decides between the safe moves
+    double discount = 0.95;
+    int table_bits = 16; // transposition table of 2^table_bits entries
+};
+
+struct SearchStats {
+    int depth = 0; // deepest complete iteration
+    long nodes = 0;
+    long evaluated = 0; // states sent to the MLP (the others came from the transposition table)
+    long table_hits = 0;
+    double elapsed_us = 0.0;
+};
+
+// Lookahead on the game rules with the MLP as a move prior. Iterative deepening, one level per
+// iteration: the new states are looked up in the transposition table (priors kept across calls) and the
+// missing ones go through one batched forward pass. Dying ends a branch, eating ends it with a reward
+// (the next apple is random), the leaves are valued by the free space around the head
+class SearchAgent {
+    struct Node {
+        SnakeState state;
+        int parent = -1;
+        int action = -1; // move from the parent
+        int depth = 0;
+        SnakeState::StepResult result = SnakeState::StepResult::Moved;
+        bool transposition = false; // already in the tree by another path, not expanded again
+        std::array<double, SnakeState::ACTION_COUNT> priors{};
+        std::array<int, SnakeState::ACTION_COUNT> children{-1, -1, -1, -1};
+        double estimate = 0.0; // leaf value
+        double value = 0.0;
+    };
+
+    struct TableEntry {
+        uint64_t key = 0;
+        uint64_t body_hash = 0; // with length, an entry only matches the same body order
+        int length = 0;
+        bool has_priors = false;
+        std::array<float, SnakeState::ACTION_COUNT> priors{};
+        uint64_t search = 0; // choose_action call that placed node in its tree
+        int node = -1;
+    };
+
+    MLP model; // own copy of the weights
+    int grid_size;
+    SearchOptions options;
+    ZobristKeys keys;
+    WorkerPool pool;
+    std::vector<TableEntry> table;
+    uint64_t search_count = 0;
+
+    // running averages used to decide whether the next depth fits in the budget
+    double move_cost_ms = 0.0; // playing, looking up and valuing one move
+    double sample_cost_ms = 0.0; // one state in the batched forward pass
+
+    std::vector<Node> nodes;
+
+    [[nodiscard]] static bool matches(const TableEntry& entry, const SnakeState& state) {
+        return entry.key == state.hash && entry.body_hash == state.body_hash &&
+               entry.length == static_cast<int>(state.body.size());
+    }
+    [[nodiscard]] std::array<double, SnakeState::ACTION_COUNT> to_priors(const Eigen::VectorXd& outputs) const;
+    void evaluate(const std::vector<int>& new_nodes, SearchStats& stats, double& predict_ms);
+    void back_up();
+
+public:
+    SearchAgent(const MLP& model, int grid_size, const SearchOptions& options = {});
+
+    // best move (0-3, URDL) for the Game.GetState vector, never a reverse
+    [[nodiscard]] int choose_action(const int* state, int size, SearchStats* stats = nullptr);
+    [[nodiscard]] int choose_action(const SnakeState& root, SearchStats* stats = nullptr);
+
+    [[nodiscard]] const ZobristKeys& get_keys() const {
+        return keys;
+    }
+};
+
+#endif //ML_LIB_SEARCHAGENT_H
@@ -0,0 +1,732 @@
+//
+// Created by maxim on 19/10/2026.
+//
+// Numerical regression checks for the MLP kernels: finite-difference gradient check of the
+// backpropagation, and every optimized path compared against a plain reference implementation
+// on the Models/ files and the Data/ csv. Returns 1 if any check fails.
+//
+// Usage: KernelCheck [repo_dir] (defaults to the directory given at build time)
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Compaction.hpp"
+#include "DataSource.hpp"
+#include "EvolutionStrategies.hpp"
+#include "HyperparameterSweep.hpp"
+#include "InferenceStats.hpp"
+#include "MLP.hpp"
+#include "MLPEnsemble.hpp"
+#include "SearchAgent.hpp"
+
+#ifndef SNAKE_REPO_DIR
+#define SNAKE_REPO_DIR ".."
+#endif
+
+namespace {
+    constexpr int CSV_ROWS = 300; // enough samples to cover the data while staying fast
+    constexpr double GRADIENT_TOLERANCE = 1e-6; // relative error of the central difference
+    constexpr double FORWARD_TOLERANCE = 1e-10; // absolute, only summation order may differ
+
+    int failures = 0;
+
+    void report(const std::string &name, const double error, const double tolerance) {
+        const bool ok = error <= tolerance;
+        if (!ok) failures++;
+        std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << ": max error " << error
+                  << " (tolerance " << tolerance << ")" << std::endl;
+    }
+
+    // first rows of a recorded csv: X = score..Y255 (520 values), Y = the 4 actions
+    bool load_csv(const std::string &path, Eigen::MatrixXd &X, Eigen::MatrixXd &Y) {
+        std::ifstream in(path);
+        if (!in.is_open()) return false;
+
+        std::string line;
+        std::getline(in, line); // header
+
+        std::vector<std::vector<double>> rows;
+        while (static_cast<int>(rows.size()) < CSV_ROWS && std::getline(in, line)) {
+            std::vector<double> row;
+            std::stringstream fields(line);
+            std::string field;
+            while (std::getline(fields, field, ',')) row.push_back(std::stod(field));
+            rows.push_back(std::move(row));
+        }
+        if (rows.empty()) return false;
+
+        const auto cols = static_cast<long>(rows[0].size());
+        X.resize(cols - 5, static_cast<long>(rows.size()));
+        Y.resize(4, static_cast<long>(rows.size()));
+        for (size_t j = 0; j < rows.size(); j++) {
+            for (long r = 0; r < cols - 5; r++) X(r, j) = rows[j][r + 1]; // skip gameOver
+            for (long r = 0; r < 4; r++) Y(r, j) = rows[j][cols - 4 + r];
+        }
+        return true;
+    }
+
+    // straight from the definition: X[l](j) = f(sum_i X[l-1](i) * W[l](i, j)), bias neuron included
+    Eigen::VectorXd reference_forward(const MLP &mlp, const Eigen::VectorXd &input) {
+        const std::vector<Eigen::MatrixXd> &W = *mlp.get_weights();
+        const auto L = static_cast<int>(W.size()) - 1;
+
+        std::vector<double> x(input.size() + 1);
+        x[0] = 1.0;
+        for (long i = 0; i < input.size(); i++) x[i + 1] = input(i);
+
+        for (int l = 1; l <= L; l++) {
+            std::vector<double> next(W[l].cols());
+            for (long j = 0; j < W[l].cols(); j++) {
+                double signal = 0.0;
+                for (long i = 0; i < W[l].rows(); i++) signal += x[i] * W[l](i, j);
+                next[j] = (mlp.is_classification() || l != L) ? std::tanh(signal) : signal;
+            }
+            x = std::move(next);
+        }
+
+        return Eigen::Map<Eigen::VectorXd>(x.data() + 1, static_cast<long>(x.size()) - 1);
+    }
+
+    // bias neuron convention of every kernel: X[0](0) = 1, X[l](0) = f(X[l-1] . W[l].col(0)) after propagate,
+    // so 0 while the bias columns are still 0 (fresh or pruned net). Max deviation over the layers
+    double bias_error(MLP &mlp, const Eigen::VectorXd &input) {
+        (void) mlp.predict(input);
+        const std::vector<Eigen::VectorXd> &activations = *mlp.get_X();
+        const std::vector<Eigen::MatrixXd> &W = *mlp.get_weights();
+        const auto L = static_cast<int>(W.size()) - 1;
+
+        double worst = std::abs(activations[0](0) - 1.0);
+        for (int l = 1; l <= L; l++) {
+            const double signal = activations[l - 1].dot(W[l].col(0));
+            const double expected = (mlp.is_classification() || l != L) ? std::tanh(signal) : signal;
+            worst = std::max(worst, std::abs(activations[l](0) - expected));
+        }
+        return worst;
+    }
+
+    // loss whose gradient MLP::gradients returns, bias output neuron included
+    double loss(MLP &mlp, const Eigen::VectorXd &input, const Eigen::VectorXd &Y) {
+        (void) mlp.predict(input);
+        const Eigen::VectorXd &output = (*mlp.get_X()).back();
+        Eigen::VectorXd Y_bias = Eigen::VectorXd::Ones(Y.size() + 1);
+        Y_bias.tail(Y.size()) = Y;
+        return 0.5 * (output - Y_bias).squaredNorm();
+    }
+
+    // central difference on max_per_layer weights of each layer (all of them when the layer is small)
+    double gradient_check(MLP &mlp, const Eigen::VectorXd &input, const Eigen::VectorXd &Y, const long max_per_layer) {
+        const std::vector<Eigen::MatrixXd> analytic = mlp.gradients(input, Y);
+        std::vector<Eigen::MatrixXd> W = *mlp.get_weights();
+        constexpr double eps = 1e-6;
+        double worst = 0.0;
+
+        for (size_t l = 1; l < W.size(); l++) {
+            const long count = std::min<long>(W[l].size(), max_per_layer);
+            const long step = std::max<long>(1, W[l].size() / count);
+
+            for (long k = 0; k < W[l].size(); k += step) {
+                const double original = W[l].data()[k];
+
+                W[l].data()[k] = original + eps;
+                mlp.set_weights(W);
+                const double plus = loss(mlp, input, Y);
+
+                W[l].data()[k] = original - eps;
+                mlp.set_weights(W);
+                const double minus = loss(mlp, input, Y);
+
+                W[l].data()[k] = original;
+
+                const double numeric = (plus - minus) / (2.0 * eps);
+                const double exact = analytic[l].data()[k];
+                const double error = std::abs(numeric - exact) / std::max(1.0, std::abs(numeric) + std::abs(exact));
+                worst = std::max(worst, error);
+            }
+        }
+
+        mlp.set_weights(W);
+        return worst;
+    }
+}
+
+int main(const int argc, char **argv) {
+    const std::filesystem::path repo = argc > 1 ? argv[1] : SNAKE_REPO_DIR;
+
+    // ===== gradient check on small random nets =====
+    for (const bool classification : {true, false}) {
+        Eigen::VectorXi NPL(4);
+        NPL << 6, 5, 4, 3;
+        MLP mlp(NPL, classification);
+
+        double worst = 0.0;
+        for (int sample = 0; sample < 5; sample++) {
+            worst = std::max(worst, gradient_check(mlp, Eigen::VectorXd::Random(6), Eigen::VectorXd::Random(3), 1000));
+        }
+        report(std::string("gradient check [6, 5, 4, 3] ") + (classification ? "classification" : "regression"),
+               worst, GRADIENT_TOLERANCE);
+    }
+
+    // ===== bias convention: fresh nets have zero bias columns, the hidden bias activations are then 0 =====
+    {
+        Eigen::VectorXi NPL(4);
+        NPL << 64, 32, 16, 4;
+        MLP mlp(NPL, true);
+
+        double worst = 0.0;
+        const auto check_zero_bias = [&worst](MLP &net) {
+            const std::vector<Eigen::MatrixXd> &W = *net.get_weights();
+            for (size_t l = 1; l < W.size(); l++) worst = std::max(worst, W[l].col(0).cwiseAbs().maxCoeff());
+
+            const Eigen::VectorXd input = Eigen::VectorXd::Random(W[1].rows() - 1);
+            worst = std::max(worst, bias_error(net, input));
+            const std::vector<Eigen::VectorXd> &activations = *net.get_X();
+            for (size_t l = 1; l < activations.size(); l++) worst = std::max(worst, std::abs(activations[l](0)));
+        };
+
+        check_zero_bias(mlp);
+        mlp.prune({0.9, false, true}); // sparse kernel path
+        worst = std::max(worst, mlp.sparse_layer_count() > 0 ? 0.0 : 1.0);
+        check_zero_bias(mlp);
+        report("bias convention fresh and pruned [64, 32, 16, 4]", worst, 0.0);
+
+        // new weights drop the pruning mask: training doesn't zero them again
+        const MLP dense(NPL, true);
+        mlp.set_weights(*dense.get_weights());
+        const double density = mlp.get_density();
+        (void) mlp.train(Eigen::MatrixXd::Random(64, 32), Eigen::MatrixXd::Random(4, 32), 16, 0.01, 1.0, 1);
+        report("set_weights clears the pruning mask", std::max(0.0, density - mlp.get_density()), 0.0);
+    }
+
+    // ===== real data and models =====
+    Eigen::MatrixXd X;
+    Eigen::MatrixXd Y;
+    if (!load_csv((repo / "Data" / "game-data-Romain.csv").string(), X, Y)) {
+        std::cout << "[FAIL] cannot read " << (repo / "Data" / "game-data-Romain.csv") << std::endl;
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> model_paths;
+    for (const auto &entry : std::filesystem::directory_iterator(repo / "Models")) {
+        if (entry.path().extension() == ".bin") model_paths.push_back(entry.path());
+    }
+    std::sort(model_paths.begin(), model_paths.end());
+
+    Eigen::VectorXi dummy_npl(2);
+    dummy_npl << 1, 1;
+
+    std::vector<MLP> models;
+    for (const auto &path : model_paths) {
+        models.emplace_back(dummy_npl, true);
+        models.back().load(path.string());
+        const std::string name = path.filename().string();
+
+        // MLP::predict against the reference forward pass
+        double worst = 0.0;
+        for (long j = 0; j < X.cols(); j++) {
+            const Eigen::VectorXd input = X.col(j);
+            worst = std::max(worst, (models.back().predict(input) - reference_forward(models.back(), input)).cwiseAbs().maxCoeff());
+        }
+        report("MLP::predict " + name, worst, FORWARD_TOLERANCE);
+
+        // batched forward pass (one GEMM per layer) against the same reference
+        const Eigen::MatrixXd batch_outputs = models.back().predict_batch(X);
+        double worst_batch = 0.0;
+        for (long j = 0; j < X.cols(); j++) {
+            worst_batch = std::max(worst_batch, (batch_outputs.col(j) - reference_forward(models.back(), X.col(j))).cwiseAbs().maxCoeff());
+        }
+        report("MLP::predict_batch " + name, worst_batch, FORWARD_TOLERANCE);
+
+        // training moves the bias columns (the bias output neuron has a target of 1),
+        // every kernel must still compute the bias activations from them
+        report("bias convention " + name, bias_error(models.back(), X.col(0)), FORWARD_TOLERANCE);
+
+        // backpropagation on the trained weights (bias columns no longer zero)
+        report("gradient check " + name, gradient_check(models.back(), X.col(0), Y.col(0), 40), GRADIENT_TOLERANCE);
+
+        // save / load round trip is bit exact
+        const std::filesystem::path copy = std::filesystem::temp_directory_path() / "kernel_check_model.bin";
+        models.back().save(copy.string());
+        MLP reloaded(dummy_npl, true);
+        reloaded.load(copy.string());
+        double diff = 0.0;
+        for (size_t l = 1; l < models.back().get_weights()->size(); l++) {
+            diff = std::max(diff, ((*reloaded.get_weights())[l] - (*models.back().get_weights())[l]).cwiseAbs().maxCoeff());
+        }
+        std::filesystem::remove(copy);
+        report("save/load " + name, diff, 0.0);
+
+        // pruned copy: block-sparse kernel against the reference forward pass, then the sparse file round trip
+        for (const bool structured : {false, true}) {
+            MLP pruned(dummy_npl, true);
+            pruned.load(path.string());
+            pruned.prune({0.9, false, structured});
+            const std::string pruned_name = std::string(structured ? "block" : "unstructured") + " pruned " + name;
+
+            double worst_pruned = pruned.sparse_layer_count() > 0 ? 0.0 : 1.0; // the sparse kernel must be selected
+            for (long j = 0; j < X.cols(); j++) {
+                const Eigen::VectorXd input = X.col(j);
+                worst_pruned = std::max(worst_pruned, (pruned.predict(input) - reference_forward(pruned, input)).cwiseAbs().maxCoeff());
+            }
+            report("sparse kernel " + pruned_name, worst_pruned, FORWARD_TOLERANCE);
+            report("bias convention " + pruned_name, bias_error(pruned, X.col(0)), FORWARD_TOLERANCE);
+
+            const std::filesystem::path sparse_copy = std::filesystem::temp_directory_path() / "kernel_check_sparse.bin";
+            pruned.save_sparse(sparse_copy.string());
+            MLP sparse_reloaded(dummy_npl, true);
+            sparse_reloaded.load(sparse_copy.string());
+            double sparse_diff = sparse_reloaded.sparse_layer_count() == pruned.sparse_layer_count() ? 0.0 : 1.0;
+            for (size_t l = 1; l < pruned.get_weights()->size(); l++) {
+                sparse_diff = std::max(sparse_diff, ((*sparse_reloaded.get_weights())[l] - (*pruned.get_weights())[l]).cwiseAbs().maxCoeff());
+            }
+            std::filesystem::remove(sparse_copy);
+            report("sparse save/load " + pruned_name, sparse_diff, 0.0);
+        }
+    }
+
+    // ===== pruning keeps every layer alive and fine-tuning still learns =====
+    {
+        const auto mean_loss = [&X, &Y](const MLP &mlp) {
+            return 0.5 * (mlp.predict_batch(X) - Y).colwise().squaredNorm().mean();
+        };
+
+        // everything asked: the hidden layers keep min_layer_density, the output layer and col(0) stay whole
+        MLP emptied = models.back();
+        emptied.prune({1.0, false, true});
+        const std::vector<Eigen::MatrixXd> &original = *models.back().get_weights();
+        const std::vector<Eigen::MatrixXd> &kept = *emptied.get_weights();
+        const auto L = static_cast<int>(kept.size()) - 1;
+        double floor_error = (kept[L] - original[L]).cwiseAbs().maxCoeff();
+        for (int l = 1; l < L; l++) {
+            const long cols = kept[l].cols() - 1;
+            const double density = static_cast<double>((kept[l].rightCols(cols).array() != 0.0).count()) /
+                                   static_cast<double>(kept[l].rows() * cols);
+            floor_error = std::max(floor_error, std::max(0.0, PruningOptions().min_layer_density - density));
+            floor_error = std::max(floor_error, (kept[l].col(0) - original[l].col(0)).cwiseAbs().maxCoeff());
+        }
+        report("pruning floor and untouched output layer", floor_error, 0.0);
+
+        // the remaining weights must still carry a gradient: the loss has to drop
+        MLP pruned = models.back();
+        pruned.prune({0.9, false, true});
+        const double before = mean_loss(pruned);
+        (void) pruned.train(X, Y, 20000, 0.001, 1.0, 1);
+        report("fine-tuning lowers the loss of a 90% pruned model (after / before)", mean_loss(pruned) / before, 0.9);
+    }
+
+    // ===== MLPEnsemble against the average / vote of the members =====
+    {
+        std::vector<const MLP*> members;
+        for (const auto &model : models) members.push_back(&model);
+        MLPEnsemble ensemble(members);
+
+        double worst_average = 0.0;
+        double worst_vote = 0.0;
+        for (long j = 0; j < X.cols(); j++) {
+            const Eigen::VectorXd input = X.col(j);
+            Eigen::VectorXd average = Eigen::VectorXd::Zero(4);
+            Eigen::VectorXd votes = Eigen::VectorXd::Zero(4);
+            for (const auto &model : models) {
+                const Eigen::VectorXd output = reference_forward(model, input);
+                Eigen::Index best;
+                output.maxCoeff(&best);
+                average += output;
+                votes(best) += 1.0;
+            }
+            average /= static_cast<double>(models.size());
+            votes /= static_cast<double>(models.size());
+
+            worst_average = std::max(worst_average, (ensemble.predict(input, EnsembleMode::Average) - average).cwiseAbs().maxCoeff());
+            worst_vote = std::max(worst_vote, (ensemble.predict(input, EnsembleMode::Vote) - votes).cwiseAbs().maxCoeff());
+        }
+        report("MLPEnsemble average", worst_average, FORWARD_TOLERANCE);
+        report("MLPEnsemble vote", worst_vote, 0.0);
+
+        // a wrong input size or an unknown mode throws instead of averaging
+        int rejected = 0;
+        try {
+            (void) ensemble.predict(Eigen::VectorXd::Zero(X.rows() + 1), EnsembleMode::Average);
+        } catch (const std::runtime_error&) {
+            rejected++;
+        }
+        try {
+            (void) ensemble.predict(X.col(0), static_cast<EnsembleMode>(2));
+        } catch (const std::runtime_error&) {
+            rejected++;
+        }
+        report("MLPEnsemble rejects invalid calls", rejected == 2 ? 0.0 : 1.0, 0.0);
+    }
+
+    // ===== hyperparameter sweep: a failing job keeps the other results =====
+    {
+        const std::filesystem::path sweep_dir = std::filesystem::temp_directory_path() / "kernel_check_sweep";
+        std::filesystem::remove_all(sweep_dir);
+
+        Eigen::VectorXi npl(3);
+        npl << static_cast<int>(X.rows()), 4, 4;
+        HyperparameterSweep sweep(true, 2);
+        sweep.add_grid({npl}, {20}, {0.01}, {0.0, 0.5}); // no training sample at 0.0: that job throws
+        const std::vector<SweepResult> results = sweep.run(X, Y, sweep_dir.string(), 2);
+
+        std::ifstream summary(sweep_dir / "sweep-summary.csv");
+        long summary_lines = 0;
+        for (std::string line; std::getline(summary, line);) summary_lines++;
+
+        const bool ok = results.size() == 2 &&
+                        !results[0].error.empty() && std::isnan(results[0].final_test_error) &&
+                        results[1].error.empty() && std::isfinite(results[1].final_test_error) &&
+                        std::filesystem::exists(sweep_dir / results[1].model_name) &&
+                        summary_lines == 3;
+        report("HyperparameterSweep failed job isolation", ok ? 0.0 : 1.0, 0.0);
+        std::filesystem::remove_all(sweep_dir);
+    }
+
+    // ===== int16 dataset file against the csv values =====
+    {
+        const std::filesystem::path dataset = std::filesystem::temp_directory_path() / "kernel_check_dataset.bin";
+        const long half = X.cols() / 2;
+        BinaryDataSource::write(dataset.string(), MemoryDataSource(X.data(), X.rows(), Y.data(), Y.rows(), half));
+        BinaryDataSource::write(dataset.string(), MemoryDataSource(X.col(half).data(), X.rows(), Y.col(half).data(),
+                                                                   Y.rows(), X.cols() - half), true);
+
+        double diff = 0.0;
+        {
+            const BinaryDataSource file(dataset.string());
+            const MemoryDataSource memory(X, Y);
+            std::vector<long> indices(X.cols());
+            for (long j = 0; j < X.cols(); j++) indices[j] = X.cols() - 1 - j;
+
+            Eigen::MatrixXd X_file, Y_file, X_memory, Y_memory;
+            file.fetch(indices, X_file, Y_file);
+            memory.fetch(indices, X_memory, Y_memory);
+            diff = file.size() == memory.size()
+                ? std::max((X_file - X_memory).cwiseAbs().maxCoeff(), (Y_file - Y_memory).cwiseAbs().maxCoeff())
+                : 1.0;
+        }
+        std::filesystem::remove(dataset);
+        report("BinaryDataSource round trip", diff, 0.0);
+    }
+
+    // ===== BatchLoader: the reader thread queue hands out the same batches as the serial path =====
+    {
+        const MemoryDataSource memory(X, Y);
+        std::vector<long> candidates(X.cols());
+        for (long j = 0; j < X.cols(); j++) candidates[j] = j;
+
+        BatchLoader serial(memory, candidates, 16, false, 7);
+        BatchLoader prefetched(memory, candidates, 16, true, 7);
+        double diff = 0.0;
+        for (int b = 0; b < 50; b++) {
+            const Batch& expected = serial.next();
+            const Batch& got = prefetched.next();
+            diff = std::max(diff, expected.indices == got.indices ? (expected.X - got.X).cwiseAbs().maxCoeff() : 1.0);
+        }
+        report("BatchLoader prefetch vs serial", diff, 0.0);
+
+        // 100 states seen once and one seen 100 times: drawn in proportion to sqrt(weight) (1/110 and 10/110),
+        // steps of 110/200 and 10 * 110/200 capped at MAX_STEP_WEIGHT
+        std::vector<double> weights(101, 1.0);
+        weights[100] = 100.0;
+        const MemoryDataSource weighted(X.data(), X.rows(), Y.data(), Y.rows(), 101, weights.data());
+        candidates.resize(101);
+        BatchLoader loader(weighted, candidates, 256, false, 7);
+        long heavy_draws = 0;
+        long draws = 0;
+        double step_diff = 0.0;
+        for (int b = 0; b < 800; b++) {
+            const Batch& batch = loader.next();
+            for (size_t j = 0; j < batch.indices.size(); j++) {
+                const bool heavy = batch.indices[j] == 100;
+                heavy_draws += heavy ? 1 : 0;
+                step_diff = std::max(step_diff, std::abs(batch.step_weights[j] -
+                                                         (heavy ? BatchLoader::MAX_STEP_WEIGHT : 110.0 / 200.0)));
+            }
+            draws += static_cast<long>(batch.indices.size());
+        }
+        report("BatchLoader tempered draws and bounded step weights",
+               std::max(step_diff, std::abs(static_cast<double>(heavy_draws) / draws - 10.0 / 110.0)), 5e-3);
+    }
+
+    // ===== dataset compaction against a std::map grouping =====
+    {
+        // reference digests of the xxHash spec (empty input, short tail, 32 bytes stripes)
+        const std::string stripes = "Nobody inspects the spammish repetition";
+        const bool hash_ok = xxhash64("", 0) == 0xEF46DB3751D8E999ULL &&
+                             xxhash64("abc", 3) == 0x44BC2CF5AD770999ULL &&
+                             xxhash64(stripes.data(), stripes.size()) == 0xFBCEA83C8A378BF1ULL;
+        report("xxhash64 reference digests", hash_ok ? 0.0 : 1.0, 0.0);
+
+        // every csv row repeated 1 to 3 times, the repeats with a shuffled target
+        std::mt19937 g(7);
+        std::vector<long> order;
+        for (long j = 0; j < X.cols(); j++) {
+            for (int r = 0; r <= static_cast<int>(j % 3); r++) order.push_back(j);
+        }
+        std::shuffle(order.begin(), order.end(), g);
+        Eigen::MatrixXd X_dup(X.rows(), static_cast<long>(order.size()));
+        Eigen::MatrixXd Y_dup(Y.rows(), static_cast<long>(order.size()));
+        for (size_t k = 0; k < order.size(); k++) {
+            X_dup.col(static_cast<long>(k)) = X.col(order[k]);
+            Y_dup.col(static_cast<long>(k)) = Y.col(order[k]);
+            if (k % 5 == 0) std::shuffle(Y_dup.col(static_cast<long>(k)).begin(), Y_dup.col(static_cast<long>(k)).end(), g);
+        }
+
+        struct Group { Eigen::VectorXd sum; double count = 0.0; };
+        std::map<std::vector<double>, Group> reference;
+        for (long k = 0; k < X_dup.cols(); k++) {
+            Group &group = reference[std::vector<double>(X_dup.col(k).begin(), X_dup.col(k).end())];
+            group.sum = group.count == 0.0 ? Eigen::VectorXd(Y_dup.col(k)) : Eigen::VectorXd(group.sum + Y_dup.col(k));
+            group.count += 1.0;
+        }
+
+        const CompactDataset compact = compact_dataset(MemoryDataSource(X_dup, Y_dup), 64);
+        double diff = compact.X.cols() == static_cast<long>(reference.size()) && compact.input_count == X_dup.cols() ? 0.0 : 1.0;
+        for (long k = 0; diff == 0.0 && k < compact.X.cols(); k++) {
+            const auto it = reference.find(std::vector<double>(compact.X.col(k).begin(), compact.X.col(k).end()));
+            if (it == reference.end()) {
+                diff = 1.0;
+                break;
+            }
+            diff = std::max(diff, std::abs(compact.weights(k) - it->second.count));
+            diff = std::max(diff, (compact.Y.col(k) - it->second.sum / it->second.count).cwiseAbs().maxCoeff());
+        }
+        report("compact_dataset groups", diff, FORWARD_TOLERANCE);
+
+        // the compacted states with their soft targets and weights in a weighted int16 file, in two chunks
+        {
+            const std::filesystem::path dataset = std::filesystem::temp_directory_path() / "kernel_check_compact.bin";
+            const long half = compact.X.cols() / 2;
+            BinaryDataSource::write(dataset.string(), MemoryDataSource(compact.X.data(), compact.X.rows(), compact.Y.data(),
+                                                                       compact.Y.rows(), half, compact.weights.data()));
+            BinaryDataSource::write(dataset.string(), MemoryDataSource(compact.X.col(half).data(), compact.X.rows(),
+                                                                       compact.Y.col(half).data(), compact.Y.rows(),
+                                                                       compact.X.cols() - half, compact.weights.data() + half),
+                                    true);
+            bool mixed_rejected = false;
+            try {
+                BinaryDataSource::write(dataset.string(), MemoryDataSource(X, Y), true);
+            } catch (const std::runtime_error&) {
+                mixed_rejected = true;
+            }
+
+            double file_diff = 1.0;
+            {
+                const BinaryDataSource file(dataset.string());
+                std::vector<long> indices(compact.X.cols());
+                std::iota(indices.begin(), indices.end(), 0);
+                Eigen::MatrixXd X_file, Y_file;
+                file.fetch(indices, X_file, Y_file);
+                if (mixed_rejected && file.size() == compact.X.cols() && file.get_weights() != nullptr) {
+                    file_diff = std::max((X_file - compact.X).cwiseAbs().maxCoeff(), (Y_file - compact.Y).cwiseAbs().maxCoeff());
+                    file_diff = std::max(file_diff, (Eigen::Map<const Eigen::VectorXd>(file.get_weights(), file.size()) -
+                                                     compact.weights).cwiseAbs().maxCoeff());
+                }
+            }
+            std::filesystem::remove(dataset);
+            report("weighted BinaryDataSource round trip", file_diff, 0.0);
+        }
+
+        // training on the compacted states with their weights ends where training on the duplicated rows does.
+        // 8 states a linear model fits exactly, one recorded 200 times: its normalized weight (~7.7) used to
+        // scale the step past the stability limit, the tempered draws keep its step weight around 1.4
+        constexpr int STATE_COUNT = 8;
+        constexpr int REPEATS = 200;
+        std::uniform_int_distribution<int> cell(-3, 3);
+        std::uniform_real_distribution<double> target(-0.8, 0.8);
+        Eigen::MatrixXd states(8, STATE_COUNT);
+        Eigen::MatrixXd targets(2, STATE_COUNT);
+        for (int s = 0; s < STATE_COUNT; s++) {
+            for (int i = 0; i < 8; i++) states(i, s) = cell(g);
+            for (int i = 0; i < 2; i++) targets(i, s) = target(g);
+        }
+        Eigen::MatrixXd X_rows(8, REPEATS + STATE_COUNT - 1);
+        Eigen::MatrixXd Y_rows(2, REPEATS + STATE_COUNT - 1);
+        for (long k = 0; k < X_rows.cols(); k++) {
+            const long s = std::max<long>(0, k - REPEATS + 1);
+            X_rows.col(k) = states.col(s);
+            Y_rows.col(k) = targets.col(s);
+        }
+        const CompactDataset states_compact = compact_dataset(MemoryDataSource(X_rows, Y_rows));
+
+        Eigen::VectorXi linear_npl(2);
+        linear_npl << 8, 2;
+        const MLP start(linear_npl, false);
+        MLP on_rows = start;
+        MLP on_states = start;
+        (void) on_rows.train(X_rows, Y_rows, 300000, 0.01, 1.0, 1);
+        (void) on_states.train(MemoryDataSource(states_compact.X, states_compact.Y, states_compact.weights.data()),
+                               300000, 0.01, 1.0, 1, {}, 256, false);
+        const Eigen::MatrixXd rows_outputs = on_rows.predict_batch(states);
+        const Eigen::MatrixXd states_outputs = on_states.predict_batch(states);
+        double training_diff = states_compact.X.cols() == STATE_COUNT ? 0.0 : 1.0;
+        training_diff = std::max(training_diff, (rows_outputs - states_outputs).cwiseAbs().maxCoeff());
+        training_diff = std::max(training_diff, (states_outputs - targets).cwiseAbs().maxCoeff());
+        if (!rows_outputs.allFinite() || !states_outputs.allFinite()) training_diff = std::numeric_limits<double>::infinity();
+        report("weighted training on compact_dataset vs duplicated rows", training_diff, 1e-3);
+    }
+
+    // ===== evolution strategies: noise slices and thread count independence =====
+    {
+        // a slice regenerated on its own (odd bounds) must match the full noise vector
+        std::vector<double> full(1001), slice(400);
+        es_noise(12345, 0, 1001, full.data());
+        es_noise(12345, 301, 701, slice.data());
+        double diff = 0.0;
+        for (size_t i = 0; i < slice.size(); i++) diff = std::max(diff, std::abs(slice[i] - full[301 + i]));
+        report("es_noise slice", diff, 0.0);
+
+        Eigen::VectorXi npl(3);
+        npl << static_cast<int>(X.rows()), 8, static_cast<int>(Y.rows());
+        MLP single(npl, true);
+        MLP parallel(npl, true);
+        parallel.set_weights(*single.get_weights());
+
+        const FitnessFunction fitness = dataset_fitness(MemoryDataSource(X, Y));
+        EvolutionOptions options;
+        options.population = 8;
+        options.generations = 3;
+        options.seed = 3;
+        options.thread_count = 1;
+        const EvolutionResults single_results = EvolutionTrainer(fitness, options).train(single);
+        options.thread_count = 3;
+        const EvolutionResults parallel_results = EvolutionTrainer(fitness, options).train(parallel);
+
+        diff = (single_results.mean_fitness - parallel_results.mean_fitness).cwiseAbs().maxCoeff();
+        for (int l = 1; l < static_cast<int>(npl.size()); l++) {
+            diff = std::max(diff, ((*single.get_weights())[l] - (*parallel.get_weights())[l]).cwiseAbs().maxCoeff());
+        }
+        report("EvolutionTrainer 1 vs 3 threads", diff, 0.0);
+    }
+
+    // ===== search agent: Game.cs rules against the recorded games =====
+    {
+        constexpr int GRID_SIZE = 16;
+        const ZobristKeys keys(GRID_SIZE);
+
+        auto game_state = [&](const long j) {
+            std::vector<int> state(X.rows() + 1, 0); // game over flag first
+            for (long i = 0; i < X.rows(); i++) state[i + 1] = static_cast<int>(X(i, j));
+            return state;
+        };
+
+        // decoding then encoding a recorded state gives it back
+        double diff = 0.0;
+        Eigen::VectorXd encoded(X.rows());
+        for (long j = 0; j < X.cols(); j++) {
+            const std::vector<int> state = game_state(j);
+            SnakeState::from_game_state(state.data(), static_cast<int>(state.size()), GRID_SIZE, keys).encode(encoded.data());
+            diff = std::max(diff, (encoded - X.col(j)).cwiseAbs().maxCoeff());
+        }
+        report("SnakeState encode round trip", diff, 0.0);
+
+        // the recorded action played on a row gives the next row (same game, no apple eaten)
+        long compared = 0;
+        long mismatches = 0;
+        double hash_diff = 0.0;
+        for (long j = 0; j + 1 < X.cols(); j++) {
+            if (X(7, j + 1) != X(7, j)) continue; // snake size changed: apple eaten or new game
+
+            const std::vector<int> state = game_state(j);
+            SnakeState snake = SnakeState::from_game_state(state.data(), static_cast<int>(state.size()), GRID_SIZE, keys);
+            Eigen::Index action = -1;
+            if (Y.col(j).maxCoeff(&action) <= 0.0) action = -1;
+
+            if (snake.step(static_cast<int>(action), keys) != SnakeState::StepResult::Moved) continue;
+            compared++;
+            snake.encode(encoded.data());
+            if ((encoded - X.col(j + 1)).cwiseAbs().maxCoeff() != 0.0) mismatches++;
+            hash_diff = std::max(hash_diff, snake.hash == keys.hash(snake) && snake.body_hash == keys.body_hash(snake) ? 0.0 : 1.0);
+        }
+        std::cout << "       " << compared << " recorded moves replayed" << std::endl;
+        report("SnakeState::step against the recorded moves", compared > 0 ? static_cast<double>(mismatches) : 1.0, 0.0);
+        report("Zobrist hash incremental vs full", hash_diff, 0.0);
+
+        // the same 3x3 block from the same tail to the same head, by rows and by columns: same Zobrist
+        // hash (same cells, head, tail and apple), the body order tells them apart
+        SnakeState by_rows;
+        SnakeState by_columns;
+        by_rows.body = {0, 1, 2, 18, 17, 16, 32, 33, 34};
+        by_columns.body = {0, 16, 32, 33, 17, 1, 2, 18, 34};
+        for (SnakeState *snake : {&by_rows, &by_columns}) {
+            snake->apple = 100;
+            snake->hash = keys.hash(*snake);
+            snake->body_hash = keys.body_hash(*snake);
+        }
+        const bool order_ok = by_rows.hash == by_columns.hash && by_rows.body_hash != by_columns.body_hash;
+        report("body order hash separates same-cell snakes", order_ok ? 0.0 : 1.0, 0.0);
+
+        // head in the corner, its only neighbour off the body is the tail: every move dies, no free space
+        SnakeState cornered;
+        cornered.body = {1, 17, 16, 0};
+        cornered.direction = 3;
+        bool cornered_ok = cornered.free_space(16) == 0;
+        for (int move = 0; move < SnakeState::ACTION_COUNT; move++) {
+            SnakeState next = cornered;
+            cornered_ok = cornered_ok && next.step(move, keys) == SnakeState::StepResult::Died;
+        }
+        report("free_space blocks the tail like step", cornered_ok ? 0.0 : 1.0, 0.0);
+
+        // heading right into the right wall, with an apple behind the wall side: must turn
+        std::vector<int> wall(2 * GRID_SIZE * GRID_SIZE + 9, 0);
+        wall[2] = 5; wall[3] = 0; wall[4] = GRID_SIZE - 1 - 5; wall[5] = GRID_SIZE - 1; // head at (5, 15)
+        wall[6] = 4; wall[7] = 0; // apple at (9, 15)
+        wall[8] = 2;
+        wall[9] = 0; wall[10] = -1; // tail at (5, 14), head last at (0, 0)
+        Eigen::VectorXi npl(3);
+        npl << static_cast<int>(X.rows()), 8, 4;
+        SearchOptions options;
+        options.thread_count = 2;
+        SearchAgent agent(MLP(npl, true), GRID_SIZE, options);
+        const int action = agent.choose_action(wall.data(), static_cast<int>(wall.size()));
+        report("SearchAgent turns before the wall (towards the apple)", action == 2 ? 0.0 : 1.0, 0.0);
+    }
+
+    // ===== latency histogram percentiles against the exact ones =====
+    {
+        LatencyHistogram histogram;
+        std::vector<uint64_t> values;
+        std::mt19937_64 g(42);
+        std::lognormal_distribution<double> latency(10.0, 1.5); // ~20 us median, long tail
+        for (int i = 0; i < 100000; i++) {
+            values.push_back(static_cast<uint64_t>(latency(g)));
+            histogram.record(values.back());
+        }
+        std::sort(values.begin(), values.end());
+
+        double worst = 0.0;
+        for (const double percent : {50.0, 90.0, 99.0, 99.9}) {
+            const auto exact = static_cast<double>(values[static_cast<size_t>(std::ceil(percent / 100.0 * values.size())) - 1]);
+            worst = std::max(worst, std::abs(static_cast<double>(histogram.percentile(percent)) - exact) / exact);
+        }
+        worst = std::max(worst, histogram.max() == values.back() && histogram.count() == values.size() ? 0.0 : 1.0);
+        report("LatencyHistogram percentiles", worst, 1.0 / LatencyHistogram::SUB_BUCKETS);
+    }
+
+    // ===== inference stats: allocated on the first record, not carried by copies =====
+    {
+        Eigen::VectorXi npl(3);
+        npl << 4, 3, 2;
+        MLP mlp(npl, true);
+        bool ok = sizeof(MLP) < sizeof(LatencyHistogram) && mlp.get_stats().predict.count() == 0;
+
+        mlp.record_stats().predict.record(1000);
+        const MLP copy = mlp;
+        ok = ok && mlp.get_stats().predict.count() == 1 && copy.get_stats().predict.count() == 0;
+        mlp.reset_stats();
+        ok = ok && mlp.get_stats().predict.count() == 0;
+        report("LazyInferenceStats", ok ? 0.0 : 1.0, 0.0);
+    }
+
+    std::cout << (failures == 0 ? "All checks passed" : std::to_string(failures) + " check(s) failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
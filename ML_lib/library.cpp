@@ -2,6 +2,13 @@
 #include <cstdint>
 
 #include "MLP.hpp"
+#include "MLPEnsemble.hpp"
+#include "HyperparameterSweep.hpp"
+#include "DataSource.hpp"
+#include "Distillation.hpp"
+#include "Compaction.hpp"
+#include "EvolutionStrategies.hpp"
+#include "SearchAgent.hpp"
 
 #if WIN32
 #define DLLEXPORT __declspec(dllexport)
@@ -11,6 +18,52 @@
 
 using MapMatrixXdRowMajor = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
 
+// fitness of a candidate model, may be called from several threads at the same time
+typedef double (*MLPFitnessCallback)(const MLP* candidate, void* user_data);
+
+namespace {
+    // load_mlp_model creates a new handle every time, its latencies are kept for the whole process
+    LatencyHistogram& load_latencies() {
+        static LatencyHistogram histogram;
+        return histogram;
+    }
+
+    // out_fitness holds [center, population mean] per generation, nullptr / 0 if the training failed
+    bool run_evolution(MLP* model, const FitnessFunction& fitness,
+                       const int32_t population, const int32_t generations,
+                       const double sigma, const double learning_rate,
+                       const int32_t thread_count, const uint64_t seed,
+                       double** out_fitness, int32_t* out_size)
+    {
+        *out_fitness = nullptr;
+        *out_size = 0;
+
+        EvolutionOptions options;
+        options.population = population;
+        options.generations = generations;
+        options.sigma = sigma;
+        options.learning_rate = learning_rate;
+        options.thread_count = thread_count;
+        options.seed = seed;
+
+        EvolutionResults results;
+        try {
+            results = EvolutionTrainer(fitness, options).train(*model);
+        } catch (...) {
+            return false;
+        }
+
+        const auto total = static_cast<int32_t>(results.center_fitness.size() * 2);
+        *out_fitness = static_cast<double*>(std::malloc(total * sizeof(double)));
+        for (Eigen::Index g = 0; g < results.center_fitness.size(); g++) {
+            (*out_fitness)[2 * g] = results.center_fitness(g);
+            (*out_fitness)[2 * g + 1] = results.mean_fitness(g);
+        }
+        *out_size = total;
+        return true;
+    }
+}
+
 extern "C" {
 
     // ======== LinearModel methods ===============
@@ -200,6 +253,9 @@ extern "C" {
         MLP *model,
         const double* X_data, const int32_t size,
         double** out_data, int32_t* out_size) {
+        InferenceStats& stats = model->record_stats();
+        const ScopedLatency latency(stats.predict);
+
         // Map the input buffer to an Eigen matrix (no copy)
         const Eigen::Map<const Eigen::VectorXd> X(X_data, size);
 
@@ -210,6 +266,7 @@ extern "C" {
         const auto total = static_cast<int32_t>(prediction.size());
         *out_data = static_cast<double*>(std::malloc(total * sizeof(double)));
         std::memcpy(*out_data, prediction.data(), total * sizeof(double));
+        stats.bytes_allocated.fetch_add(total * sizeof(double), std::memory_order_relaxed);
 
         *out_size = static_cast<int32_t>(prediction.size());
     }
@@ -254,6 +311,119 @@ extern "C" {
         std::memcpy(*out_test_error, results.test_errors.data(), results.test_errors.size() * sizeof(double));
     }
 
+    // Same as train_mlp with patience-based early stopping on the test error.
+    // checkpoint_path can be null, out_best_index is the evaluation the returned weights come from.
+    // sample_weights (one per sample, e.g. from compact_dataset) can be null for uniform weights.
+    // Returns false if the data, the weights or the options are invalid
+    DLLEXPORT bool train_mlp_early_stopping(
+        MLP* model,
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        double** out_train_error, int32_t* out_train_size,
+        double** out_test_error, int32_t* out_test_size,
+        int32_t* out_best_index,
+        const int32_t num_iter,
+        const float learning_rate,
+        const double train_proportion,
+        const int32_t error_list_size,
+        const int32_t patience,
+        const bool restore_best,
+        const char* checkpoint_path,
+        const int32_t checkpoint_every,
+        const double* sample_weights)
+    {
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd Y = MapMatrixXdRowMajor(Y_data, Y_rows, Y_cols);
+
+        EarlyStoppingOptions early_stopping;
+        early_stopping.patience = patience;
+        early_stopping.restore_best = restore_best;
+        early_stopping.checkpoint_path = checkpoint_path != nullptr ? checkpoint_path : "";
+        early_stopping.checkpoint_every = checkpoint_every;
+
+        TrainingResults results;
+        try {
+            results = model->train(
+                MemoryDataSource(X, Y, sample_weights),
+                num_iter,
+                learning_rate,
+                train_proportion,
+                error_list_size,
+                early_stopping,
+                256,
+                false
+            );
+        } catch (...) {
+            *out_train_error = *out_test_error = nullptr;
+            *out_train_size = *out_test_size = 0;
+            *out_best_index = -1;
+            return false;
+        }
+
+        *out_best_index = results.best_error_index;
+
+        // --- Handle Train Error Memory ---
+        *out_train_size = static_cast<int32_t>(results.train_errors.size());
+        *out_train_error = static_cast<double*>(std::malloc(results.train_errors.size() * sizeof(double)));
+        std::memcpy(*out_train_error, results.train_errors.data(), results.train_errors.size() * sizeof(double));
+
+        // --- Handle Test Error Memory ---
+        *out_test_size = static_cast<int32_t>(results.test_errors.size());
+        *out_test_error = static_cast<double*>(std::malloc(results.test_errors.size() * sizeof(double)));
+        std::memcpy(*out_test_error, results.test_errors.data(), results.test_errors.size() * sizeof(double));
+        return true;
+    }
+
+    // Trains from a dataset file written by write_int16_dataset, memory mapped instead of loaded,
+    // batches of batch_size samples are decoded on a reader thread. Returns false if the file can't be used
+    DLLEXPORT bool train_mlp_from_file(
+        MLP* model,
+        const char* dataset_path,
+        double** out_train_error, int32_t* out_train_size,
+        double** out_test_error, int32_t* out_test_size,
+        int32_t* out_best_index,
+        const int32_t num_iter,
+        const float learning_rate,
+        const double train_proportion,
+        const int32_t error_list_size,
+        const int32_t batch_size,
+        const int32_t patience,
+        const bool restore_best,
+        const char* checkpoint_path,
+        const int32_t checkpoint_every)
+    {
+        EarlyStoppingOptions early_stopping;
+        early_stopping.patience = patience;
+        early_stopping.restore_best = restore_best;
+        early_stopping.checkpoint_path = checkpoint_path != nullptr ? checkpoint_path : "";
+        early_stopping.checkpoint_every = checkpoint_every;
+
+        TrainingResults results;
+        try {
+            const BinaryDataSource data((std::string(dataset_path)));
+            results = model->train(data, num_iter, learning_rate, train_proportion, error_list_size,
+                                   early_stopping, batch_size, true);
+        } catch (...) {
+            *out_train_error = *out_test_error = nullptr;
+            *out_train_size = *out_test_size = 0;
+            *out_best_index = -1;
+            return false;
+        }
+
+        *out_best_index = results.best_error_index;
+
+        // --- Handle Train Error Memory ---
+        *out_train_size = static_cast<int32_t>(results.train_errors.size());
+        *out_train_error = static_cast<double*>(std::malloc(results.train_errors.size() * sizeof(double)));
+        std::memcpy(*out_train_error, results.train_errors.data(), results.train_errors.size() * sizeof(double));
+
+        // --- Handle Test Error Memory ---
+        *out_test_size = static_cast<int32_t>(results.test_errors.size());
+        *out_test_error = static_cast<double*>(std::malloc(results.test_errors.size() * sizeof(double)));
+        std::memcpy(*out_test_error, results.test_errors.data(), results.test_errors.size() * sizeof(double));
+        return true;
+    }
+
     DLLEXPORT void release_mlp(const MLP *model) {
         delete model;
     }
@@ -266,6 +436,8 @@ extern "C" {
 
     // This function creates a NEW MLP pointer from a file
     DLLEXPORT MLP* load_mlp_model(const char* filepath) {
+        const auto start = std::chrono::steady_clock::now();
+
         // We create a dummy MLP first.
         // The load function will overwrite NPL and resize everything.
         // We pass minimal valid NPL {1, 1} just to satisfy the constructor.
@@ -281,6 +453,433 @@ extern "C" {
             return nullptr; // Return null if file not found/corrupted
         }
 
+        InferenceStats& stats = model->record_stats();
+        for (const auto &W : *model->get_weights()) {
+            stats.bytes_allocated.fetch_add(W.size() * sizeof(double), std::memory_order_relaxed);
+        }
+        load_latencies().record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+
         return model;
     }
+
+    // Scrapes the counters of a model handle into out_stats (9 doubles, allocated by the caller):
+    // predict count, p50, p99, max, load count, p50, p99, max, bytes allocated. Latencies are in microseconds.
+    // Only predict_one_mlp and load_mlp_model are measured. The load values cover every load_mlp_model call
+    // of the process (each call makes a new handle), reset = true only clears the counters of this model:
+    // reset_mlp_load_stats clears the load values
+    DLLEXPORT void get_mlp_stats(MLP* model, double* out_stats, const bool reset) {
+        const InferenceStats& stats = model->get_stats();
+        const LatencyHistogram& load = load_latencies();
+        int i = 0;
+        for (const LatencyHistogram* histogram : {&stats.predict, &load}) {
+            out_stats[i++] = static_cast<double>(histogram->count());
+            out_stats[i++] = static_cast<double>(histogram->percentile(50.0)) / 1000.0;
+            out_stats[i++] = static_cast<double>(histogram->percentile(99.0)) / 1000.0;
+            out_stats[i++] = static_cast<double>(histogram->max()) / 1000.0;
+        }
+        out_stats[i] = static_cast<double>(stats.bytes_allocated.load(std::memory_order_relaxed));
+
+        if (reset) {
+            model->reset_stats();
+        }
+    }
+
+    // Clears the load values reported by get_mlp_stats, shared by every model handle
+    DLLEXPORT void reset_mlp_load_stats() {
+        load_latencies().reset();
+    }
+
+    // Zeroes the smallest hidden layer weights (sparsity = share removed, each layer keeps at least 5%).
+    // The mask is kept, so train_mlp afterward fine-tunes the remaining weights only.
+    // Returns false if sparsity isn't in [0, 1] or the model has no hidden layer
+    DLLEXPORT bool prune_mlp(MLP* model, const double sparsity, const bool per_layer, const bool structured) {
+        try {
+            model->prune({sparsity, per_layer, structured});
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+
+    DLLEXPORT void clear_mlp_mask(MLP* model) {
+        model->clear_mask();
+    }
+
+    DLLEXPORT double get_mlp_density(const MLP* model) {
+        return model->get_density();
+    }
+
+    // Only the non zero weights are written, load_mlp_model reads both formats
+    DLLEXPORT void save_mlp_model_sparse(MLP* model, const char* filepath) {
+        if (model != nullptr) {
+            model->save_sparse(std::string(filepath));
+        }
+    }
+
+    // ============= Distillation related method ================
+
+    // Teacher outputs on X (one sample per column), computed once by batches and kept for train_mlp_distilled.
+    // Returns nullptr if X doesn't match the teacher input size
+    DLLEXPORT TeacherOutputs* compute_teacher_outputs(
+        const MLP* teacher,
+        const double* X_data, const int32_t X_rows, const int32_t X_cols)
+    {
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd no_targets(0, X.cols());
+
+        try {
+            return new TeacherOutputs(*teacher, MemoryDataSource(X, no_targets));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    DLLEXPORT void save_teacher_outputs(const TeacherOutputs* outputs, const char* filepath) {
+        if (outputs != nullptr) {
+            outputs->save(std::string(filepath));
+        }
+    }
+
+    // Returns nullptr if the file is missing or invalid
+    DLLEXPORT TeacherOutputs* load_teacher_outputs(const char* filepath) {
+        try {
+            return new TeacherOutputs(std::string(filepath));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    DLLEXPORT void release_teacher_outputs(const TeacherOutputs* outputs) {
+        delete outputs;
+    }
+
+    // Same as train_mlp, with the targets replaced by teacher_weight * teacher + (1 - teacher_weight) * Y.
+    // X and Y must be the samples the teacher outputs were computed on (same order).
+    // Returns false (and no buffers) if they don't match
+    DLLEXPORT bool train_mlp_distilled(
+        MLP* model,
+        const TeacherOutputs* teacher_outputs,
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        const double teacher_weight,
+        double** out_train_error, int32_t* out_train_size,
+        double** out_test_error, int32_t* out_test_size,
+        const int32_t num_iter,
+        const float learning_rate,
+        const double train_proportion,
+        const int32_t error_list_size)
+    {
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd Y = MapMatrixXdRowMajor(Y_data, Y_rows, Y_cols);
+
+        TrainingResults results;
+        try {
+            results = model->train_distilled(*teacher_outputs, MemoryDataSource(X, Y), teacher_weight,
+                                             num_iter, learning_rate, train_proportion, error_list_size);
+        } catch (...) {
+            *out_train_error = *out_test_error = nullptr;
+            *out_train_size = *out_test_size = 0;
+            return false;
+        }
+
+        // --- Handle Train Error Memory ---
+        *out_train_size = static_cast<int32_t>(results.train_errors.size());
+        *out_train_error = static_cast<double*>(std::malloc(results.train_errors.size() * sizeof(double)));
+        std::memcpy(*out_train_error, results.train_errors.data(), results.train_errors.size() * sizeof(double));
+
+        // --- Handle Test Error Memory ---
+        *out_test_size = static_cast<int32_t>(results.test_errors.size());
+        *out_test_error = static_cast<double*>(std::malloc(results.test_errors.size() * sizeof(double)));
+        std::memcpy(*out_test_error, results.test_errors.data(), results.test_errors.size() * sizeof(double));
+        return true;
+    }
+
+    // ============= Dataset compaction ================
+
+    // Merges the identical states of X (features x samples, integer values) into unique samples:
+    // out_X holds the unique states (same layout), out_Y the mean of their targets and out_weights
+    // how many samples each one stands for (to pass to train_mlp_early_stopping).
+    // Returns false (and no buffers) if X and Y don't match or X has non int16 values
+    DLLEXPORT bool compact_dataset(
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        double** out_X, double** out_Y, double** out_weights,
+        int32_t* out_count, int32_t* out_conflicts)
+    {
+        *out_X = *out_Y = *out_weights = nullptr;
+        *out_count = *out_conflicts = 0;
+
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd Y = MapMatrixXdRowMajor(Y_data, Y_rows, Y_cols);
+
+        CompactDataset compact;
+        try {
+            compact = compact_dataset(MemoryDataSource(X, Y));
+        } catch (...) {
+            return false;
+        }
+
+        // back to the row-major layout of the inputs
+        using MatrixXdRowMajor = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        const MatrixXdRowMajor X_unique = compact.X;
+        const MatrixXdRowMajor Y_unique = compact.Y;
+
+        *out_X = static_cast<double*>(std::malloc(X_unique.size() * sizeof(double)));
+        *out_Y = static_cast<double*>(std::malloc(Y_unique.size() * sizeof(double)));
+        *out_weights = static_cast<double*>(std::malloc(compact.weights.size() * sizeof(double)));
+        std::memcpy(*out_X, X_unique.data(), X_unique.size() * sizeof(double));
+        std::memcpy(*out_Y, Y_unique.data(), Y_unique.size() * sizeof(double));
+        std::memcpy(*out_weights, compact.weights.data(), compact.weights.size() * sizeof(double));
+
+        *out_count = static_cast<int32_t>(compact.weights.size());
+        *out_conflicts = static_cast<int32_t>(compact.conflict_count);
+        return true;
+    }
+
+    // ============= MLPEnsemble related method ================
+
+    // Returns nullptr if the models can't be combined (different input or output size)
+    DLLEXPORT MLPEnsemble* create_mlp_ensemble(const MLP* const* models, const int32_t model_count) {
+        if (models == nullptr || model_count <= 0) {
+            return nullptr;
+        }
+
+        const std::vector<const MLP*> members(models, models + model_count);
+
+        try {
+            return new MLPEnsemble(members);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    // mode: 0 = average of the outputs, 1 = vote (share of members choosing each action).
+    // Returns false (out_data null) if the input size doesn't match the ensemble or the mode is unknown
+    DLLEXPORT bool predict_one_mlp_ensemble(
+        MLPEnsemble *ensemble,
+        const double* X_data, const int32_t size,
+        const int32_t mode,
+        double** out_data, int32_t* out_size) {
+        *out_data = nullptr;
+        *out_size = 0;
+        if (ensemble == nullptr || (mode != static_cast<int32_t>(EnsembleMode::Average) &&
+                                    mode != static_cast<int32_t>(EnsembleMode::Vote))) {
+            return false;
+        }
+
+        // Map the input buffer to an Eigen matrix (no copy)
+        const Eigen::Map<const Eigen::VectorXd> X(X_data, size);
+
+        // Do the prediction
+        Eigen::VectorXd prediction;
+        try {
+            prediction = ensemble->predict(X, static_cast<EnsembleMode>(mode));
+        } catch (...) {
+            return false;
+        }
+
+        // Allocate a flat buffer for the output
+        const auto total = static_cast<int32_t>(prediction.size());
+        *out_data = static_cast<double*>(std::malloc(total * sizeof(double)));
+        std::memcpy(*out_data, prediction.data(), total * sizeof(double));
+
+        *out_size = total;
+        return true;
+    }
+
+    DLLEXPORT void release_mlp_ensemble(const MLPEnsemble *ensemble) {
+        delete ensemble;
+    }
+
+    // ============= HyperparameterSweep related method ================
+
+    // Trains every config on one shared copy of X/Y and saves the models in output_dir (with sweep-summary.csv).
+    // npl_data holds the topologies one after another, npl_sizes the number of layers of each one.
+    // random_count == 0: grid over all the values, otherwise random_count configs with the learning rate
+    // drawn log-uniformly between learning_rates[0] and learning_rates[1].
+    // out_errors holds [final_train_mse, final_test_mse] per config (NaN for a config whose training failed,
+    // see sweep-summary.csv), out_size = 0 if the sweep couldn't run at all.
+    DLLEXPORT void run_mlp_sweep(
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        const int32_t* npl_data, const int32_t* npl_sizes, const int32_t topology_count,
+        const int32_t* num_iters, const int32_t num_iter_count,
+        const double* learning_rates, const int32_t learning_rate_count,
+        const double* train_proportions, const int32_t train_proportion_count,
+        const int32_t random_count, const uint32_t seed,
+        const bool is_classification, const int32_t error_list_size,
+        const char* output_dir, const int32_t thread_count,
+        double** out_errors, int32_t* out_size)
+    {
+        *out_errors = nullptr;
+        *out_size = 0;
+
+        // single column-major copy, shared read-only by every training job
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd Y = MapMatrixXdRowMajor(Y_data, Y_rows, Y_cols);
+
+        std::vector<Eigen::VectorXi> topologies;
+        for (int32_t t = 0, offset = 0; t < topology_count; offset += npl_sizes[t], t++) {
+            topologies.emplace_back(Eigen::Map<const Eigen::VectorXi>(npl_data + offset, npl_sizes[t]));
+        }
+        const std::vector<int> iters(num_iters, num_iters + num_iter_count);
+        const std::vector<double> lrs(learning_rates, learning_rates + learning_rate_count);
+        const std::vector<double> proportions(train_proportions, train_proportions + train_proportion_count);
+
+        std::vector<SweepResult> results;
+        try {
+            HyperparameterSweep sweep(is_classification, error_list_size);
+            if (random_count > 0) {
+                sweep.add_random(topologies, iters, lrs.at(0), lrs.at(1), proportions, random_count, seed);
+            } else {
+                sweep.add_grid(topologies, iters, lrs, proportions);
+            }
+            results = sweep.run(X, Y, std::string(output_dir), thread_count);
+        } catch (...) {
+            return;
+        }
+
+        const auto total = static_cast<int32_t>(results.size() * 2);
+        *out_errors = static_cast<double*>(std::malloc(total * sizeof(double)));
+        for (size_t i = 0; i < results.size(); i++) {
+            (*out_errors)[2 * i] = results[i].final_train_error;
+            (*out_errors)[2 * i + 1] = results[i].final_test_error;
+        }
+        *out_size = total;
+    }
+
+    // ============= Evolution strategies related method ================
+
+    // Gradient free training from the current weights (e.g. a loaded model), the fitness is the accuracy
+    // on X/Y (minus the MSE for regression). Returns false if the data or the options are invalid
+    DLLEXPORT bool train_mlp_evolution(
+        MLP* model,
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        const int32_t population, const int32_t generations,
+        const double sigma, const double learning_rate,
+        const int32_t thread_count, const uint64_t seed,
+        double** out_fitness, int32_t* out_size)
+    {
+        const Eigen::MatrixXd X = MapMatrixXdRowMajor(X_data, X_rows, X_cols);
+        const Eigen::MatrixXd Y = MapMatrixXdRowMajor(Y_data, Y_rows, Y_cols);
+
+        FitnessFunction fitness;
+        try {
+            fitness = dataset_fitness(MemoryDataSource(X, Y));
+        } catch (...) {
+            *out_fitness = nullptr;
+            *out_size = 0;
+            return false;
+        }
+
+        return run_evolution(model, fitness, population, generations, sigma, learning_rate, thread_count, seed,
+                             out_fitness, out_size);
+    }
+
+    // Same with the fitness computed by the caller (e.g. a game score), candidate is only valid during the call
+    DLLEXPORT bool train_mlp_evolution_callback(
+        MLP* model,
+        const MLPFitnessCallback callback, void* user_data,
+        const int32_t population, const int32_t generations,
+        const double sigma, const double learning_rate,
+        const int32_t thread_count, const uint64_t seed,
+        double** out_fitness, int32_t* out_size)
+    {
+        if (callback == nullptr) {
+            *out_fitness = nullptr;
+            *out_size = 0;
+            return false;
+        }
+
+        const FitnessFunction fitness = [callback, user_data](const MLP &candidate) {
+            return callback(&candidate, user_data);
+        };
+        return run_evolution(model, fitness, population, generations, sigma, learning_rate, thread_count, seed,
+                             out_fitness, out_size);
+    }
+
+    // ============= SearchAgent related method ================
+
+    // Lookahead agent on a copy of the model (it can be released afterward), for a grid_size x grid_size game.
+    // time_budget_ms bounds each search_agent_action call, thread_count = 0 uses all hardware threads.
+    // Returns nullptr if the model doesn't take the game state of that grid
+    DLLEXPORT SearchAgent* create_search_agent(
+        const MLP* model, const int32_t grid_size,
+        const int32_t max_depth, const double time_budget_ms, const int32_t thread_count)
+    {
+        if (model == nullptr) {
+            return nullptr;
+        }
+
+        SearchOptions options;
+        options.max_depth = max_depth;
+        options.time_budget_ms = time_budget_ms;
+        options.thread_count = thread_count;
+
+        try {
+            return new SearchAgent(*model, grid_size, options);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    // Next action (0-3, URDL) for the Game.GetState vector, -1 if there is no agent or the state doesn't match the grid.
+    // out_stats (can be null) holds [depth, nodes, evaluated, table_hits, elapsed_us]
+    DLLEXPORT int32_t search_agent_action(
+        SearchAgent* agent,
+        const int32_t* state, const int32_t size,
+        double* out_stats)
+    {
+        if (agent == nullptr) {
+            return -1;
+        }
+
+        SearchStats stats;
+        int32_t action;
+        try {
+            action = agent->choose_action(state, size, &stats);
+        } catch (...) {
+            return -1;
+        }
+
+        if (out_stats != nullptr) {
+            out_stats[0] = stats.depth;
+            out_stats[1] = static_cast<double>(stats.nodes);
+            out_stats[2] = static_cast<double>(stats.evaluated);
+            out_stats[3] = static_cast<double>(stats.table_hits);
+            out_stats[4] = stats.elapsed_us;
+        }
+        return action;
+    }
+
+    DLLEXPORT void release_search_agent(const SearchAgent* agent) {
+        delete agent;
+    }
+
+    // ============= Dataset file related method ================
+
+    // Writes X/Y (one sample per column) as a compact int16 dataset file for train_mlp_from_file.
+    // sample_weights (X_cols values, e.g. the counts of compact_dataset) are stored in the file with the
+    // targets as doubles, train_mlp_from_file then uses them; nullptr for unweighted samples.
+    // append = true adds the samples to an existing file. Returns false if a value doesn't fit in an int16
+    DLLEXPORT bool write_int16_dataset(
+        const double* X_data, const int32_t X_rows, const int32_t X_cols,
+        const double* Y_data, const int32_t Y_rows, const int32_t Y_cols,
+        const double* sample_weights,
+        const char* filepath, const bool append)
+    {
+        const MapMatrixXdRowMajor X(X_data, X_rows, X_cols);
+        const MapMatrixXdRowMajor Y(Y_data, Y_rows, Y_cols);
+
+        try {
+            const Eigen::MatrixXd X_copy(X);
+            const Eigen::MatrixXd Y_copy(Y);
+            BinaryDataSource::write(std::string(filepath), MemoryDataSource(X_copy, Y_copy, sample_weights), append);
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,610 @@
+//
+// Created by maxim on 19/10/2026.
+//
+// Python extension module exposing MLP without ctypes marshalling:
+// - numpy arrays are read in place through the buffer protocol (float64, C-contiguous, one sample per row)
+// - results and weights are returned as numpy arrays viewing the native memory
+// - the GIL is released while training or predicting, so models can be trained from several Python threads
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <mutex>
+#include <string>
+
+#include "DataSource.hpp"
+#include "MLP.hpp"
+
+namespace {
+
+// ============= NativeArray: float64 memory exported through the buffer protocol ================
+
+struct NativeArrayObject {
+    PyObject_HEAD
+    Eigen::VectorXd* vector_storage; // owned data, both nullptr when viewing the memory of owner
+    Eigen::MatrixXd* matrix_storage;
+    PyObject* owner;          // kept alive while the array exists
+    double* data;
+    int ndim;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+};
+
+void NativeArray_dealloc(NativeArrayObject* self) {
+    delete self->vector_storage;
+    delete self->matrix_storage;
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+int NativeArray_getbuffer(NativeArrayObject* self, Py_buffer* view, const int flags) {
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "native arrays are read-only");
+        return -1;
+    }
+
+    const bool c_contiguous = self->ndim == 1 || self->strides[1] == sizeof(double);
+    if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES && !c_contiguous) {
+        PyErr_SetString(PyExc_BufferError, "native array is not C-contiguous, strides are required");
+        return -1;
+    }
+
+    view->obj = reinterpret_cast<PyObject*>(self);
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = self->shape[0] * (self->ndim == 2 ? self->shape[1] : 1) * static_cast<Py_ssize_t>(sizeof(double));
+    view->readonly = 1;
+    view->itemsize = sizeof(double);
+    view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>("d") : nullptr;
+    view->ndim = self->ndim;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? self->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+PyBufferProcs NativeArray_as_buffer = {
+    reinterpret_cast<getbufferproc>(NativeArray_getbuffer),
+    nullptr,
+};
+
+PyTypeObject NativeArrayType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "ml_lib_native.NativeArray",
+};
+
+PyObject* numpy_asarray = nullptr; // numpy.asarray, nullptr if numpy isn't installed
+
+// wrap the array in a numpy view (a memoryview without numpy), steals the reference
+PyObject* to_python_array(NativeArrayObject* array) {
+    if (array == nullptr) return nullptr;
+
+    PyObject* result = numpy_asarray != nullptr
+        ? PyObject_CallOneArg(numpy_asarray, reinterpret_cast<PyObject*>(array))
+        : PyMemoryView_FromObject(reinterpret_cast<PyObject*>(array));
+    Py_DECREF(array);
+    return result;
+}
+
+NativeArrayObject* new_native_array() {
+    auto* array = PyObject_New(NativeArrayObject, &NativeArrayType);
+    if (array == nullptr) return nullptr;
+    array->vector_storage = nullptr;
+    array->matrix_storage = nullptr;
+    array->owner = nullptr;
+    array->data = nullptr;
+    return array;
+}
+
+// array owning a vector (moved, not copied)
+PyObject* owned_vector(Eigen::VectorXd&& values) {
+    NativeArrayObject* array = new_native_array();
+    if (array == nullptr) return nullptr;
+    array->vector_storage = new Eigen::VectorXd(std::move(values));
+    array->data = array->vector_storage->data();
+    array->ndim = 1;
+    array->shape[0] = array->vector_storage->size();
+    array->strides[0] = sizeof(double);
+    return to_python_array(array);
+}
+
+// (rows, cols) C-ordered array over a column-major (cols x rows) matrix, one sample per row
+PyObject* owned_samples(Eigen::MatrixXd&& values) {
+    NativeArrayObject* array = new_native_array();
+    if (array == nullptr) return nullptr;
+    array->matrix_storage = new Eigen::MatrixXd(std::move(values));
+    array->data = array->matrix_storage->data();
+    array->ndim = 2;
+    array->shape[0] = array->matrix_storage->cols();
+    array->shape[1] = array->matrix_storage->rows();
+    array->strides[0] = array->matrix_storage->rows() * static_cast<Py_ssize_t>(sizeof(double));
+    array->strides[1] = sizeof(double);
+    return to_python_array(array);
+}
+
+// view over a matrix owned by another object (column-major, so Fortran-ordered)
+PyObject* matrix_view(PyObject* owner, const Eigen::MatrixXd& matrix) {
+    NativeArrayObject* array = new_native_array();
+    if (array == nullptr) return nullptr;
+    Py_INCREF(owner);
+    array->owner = owner;
+    array->data = const_cast<double*>(matrix.data());
+    array->ndim = 2;
+    array->shape[0] = matrix.rows();
+    array->shape[1] = matrix.cols();
+    array->strides[0] = sizeof(double);
+    array->strides[1] = matrix.rows() * static_cast<Py_ssize_t>(sizeof(double));
+    return to_python_array(array);
+}
+
+// ============= input buffers ================
+
+// float64 C-contiguous buffer borrowed from a Python object (no copy), released on destruction
+struct InputBuffer {
+    Py_buffer view{};
+    bool acquired = false;
+
+    ~InputBuffer() {
+        if (acquired) PyBuffer_Release(&view);
+    }
+
+    bool acquire(PyObject* object, const char* name) {
+        if (PyObject_GetBuffer(object, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+            PyErr_Format(PyExc_TypeError, "%s must be a C-contiguous buffer (use np.ascontiguousarray)", name);
+            return false;
+        }
+        acquired = true;
+
+        const std::string format = view.format != nullptr ? view.format : "B";
+        if (view.itemsize != sizeof(double) || format.empty() || format.back() != 'd') {
+            PyErr_Format(PyExc_TypeError, "%s must hold float64 values (use .astype(np.float64))", name);
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] const double* data() const { return static_cast<const double*>(view.buf); }
+    [[nodiscard]] Py_ssize_t size() const { return view.len / static_cast<Py_ssize_t>(sizeof(double)); }
+    [[nodiscard]] Py_ssize_t rows() const { return view.ndim >= 1 ? view.shape[0] : 1; }
+};
+
+// ============= MLP type ================
+
+struct MLPObject {
+    PyObject_HEAD
+    MLP* model;
+    std::mutex* lock; // serialises calls on the same model once the GIL is released
+};
+
+void MLP_dealloc(MLPObject* self) {
+    delete self->model;
+    delete self->lock;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* MLP_new(PyTypeObject* type, PyObject*, PyObject*) {
+    auto* self = reinterpret_cast<MLPObject*>(type->tp_alloc(type, 0));
+    if (self != nullptr) {
+        self->model = nullptr;
+        self->lock = new std::mutex();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+int MLP_init(MLPObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"layers", "is_classification", nullptr};
+    PyObject* layers = nullptr;
+    int is_classification = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", const_cast<char**>(keywords), &layers, &is_classification)) {
+        return -1;
+    }
+
+    PyObject* sequence = PySequence_Fast(layers, "layers must be a sequence of int");
+    if (sequence == nullptr) return -1;
+
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    Eigen::VectorXi NPL(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        NPL(i) = static_cast<int>(PyLong_AsLong(PySequence_Fast_GET_ITEM(sequence, i)));
+    }
+    Py_DECREF(sequence);
+    if (PyErr_Occurred()) return -1;
+
+    if (count < 2) {
+        PyErr_SetString(PyExc_ValueError, "layers needs at least an input and an output size");
+        return -1;
+    }
+
+    // get_weights views point into the model, replacing it would leave them on freed memory
+    if (self->model != nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "MLP is already initialised, create a new one");
+        return -1;
+    }
+    self->model = new MLP(NPL, is_classification != 0);
+    return 0;
+}
+
+bool check_model(const MLPObject* self) {
+    if (self->model == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "MLP is not initialised");
+        return false;
+    }
+    return true;
+}
+
+PyTypeObject MLPType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "ml_lib_native.MLP",
+};
+
+PyObject* MLP_load(PyObject*, PyObject* args) {
+    const char* filepath = nullptr;
+    if (!PyArg_ParseTuple(args, "s", &filepath)) return nullptr;
+
+    auto* self = reinterpret_cast<MLPObject*>(MLP_new(&MLPType, nullptr, nullptr));
+    if (self == nullptr) return nullptr;
+
+    Eigen::VectorXi dummy_npl(2);
+    dummy_npl << 1, 1;
+    self->model = new MLP(dummy_npl, true);
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        self->model->load(filepath);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        Py_DECREF(self);
+        PyErr_SetString(PyExc_IOError, error.c_str());
+        return nullptr;
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+PyObject* MLP_save(MLPObject* self, PyObject* args) {
+    const char* filepath = nullptr;
+    if (!PyArg_ParseTuple(args, "s", &filepath) || !check_model(self)) return nullptr;
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        self->model->save(filepath);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_IOError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* MLP_predict(MLPObject* self, PyObject* args) {
+    PyObject* input = nullptr;
+    if (!PyArg_ParseTuple(args, "O", &input) || !check_model(self)) return nullptr;
+
+    InputBuffer x;
+    if (!x.acquire(input, "x")) return nullptr;
+
+    const int input_size = self->model->get_input_size();
+    if (x.size() != input_size) {
+        PyErr_Format(PyExc_ValueError, "x has %zd values, the model expects %d", x.size(), input_size);
+        return nullptr;
+    }
+
+    Eigen::VectorXd prediction;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        prediction = self->model->predict(Eigen::VectorXd(Eigen::Map<const Eigen::VectorXd>(x.data(), input_size)));
+    }
+    Py_END_ALLOW_THREADS
+
+    return owned_vector(std::move(prediction));
+}
+
+PyObject* MLP_predict_batch(MLPObject* self, PyObject* args) {
+    PyObject* input = nullptr;
+    if (!PyArg_ParseTuple(args, "O", &input) || !check_model(self)) return nullptr;
+
+    InputBuffer X;
+    if (!X.acquire(input, "X")) return nullptr;
+
+    const int input_size = self->model->get_input_size();
+    if (X.size() != X.rows() * input_size) {
+        PyErr_Format(PyExc_ValueError, "X must have shape (samples, %d)", input_size);
+        return nullptr;
+    }
+
+    // C-ordered (samples, features) is a column-major (features, samples) matrix
+    const Eigen::Map<const Eigen::MatrixXd> samples(X.data(), input_size, X.rows());
+    Eigen::MatrixXd predictions;
+
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        predictions = self->model->predict_batch(Eigen::MatrixXd(samples)); // whole batch, one GEMM per layer
+    }
+    Py_END_ALLOW_THREADS
+
+    return owned_samples(std::move(predictions));
+}
+
+PyObject* training_results(TrainingResults&& results) {
+    PyObject* train = owned_vector(std::move(results.train_errors));
+    PyObject* test = owned_vector(std::move(results.test_errors));
+    if (train == nullptr || test == nullptr) {
+        Py_XDECREF(train);
+        Py_XDECREF(test);
+        return nullptr;
+    }
+    return Py_BuildValue("(NNi)", train, test, results.best_error_index);
+}
+
+PyObject* MLP_train(MLPObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"X", "Y", "num_iter", "lr", "train_proportion", "error_list_size",
+                                     "patience", "restore_best", "checkpoint_path", "checkpoint_every", nullptr};
+    PyObject* X_object = nullptr;
+    PyObject* Y_object = nullptr;
+    int num_iter = 1000;
+    double lr = 0.01;
+    double train_proportion = 0.8;
+    int error_list_size = 1000;
+    EarlyStoppingOptions early_stopping;
+    int restore_best = 1;
+    const char* checkpoint_path = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|iddiipzi", const_cast<char**>(keywords),
+                                     &X_object, &Y_object, &num_iter, &lr, &train_proportion, &error_list_size,
+                                     &early_stopping.patience, &restore_best, &checkpoint_path,
+                                     &early_stopping.checkpoint_every) || !check_model(self)) {
+        return nullptr;
+    }
+    if (error_list_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "error_list_size must be > 0");
+        return nullptr;
+    }
+    early_stopping.restore_best = restore_best != 0;
+    early_stopping.checkpoint_path = checkpoint_path != nullptr ? checkpoint_path : "";
+
+    InputBuffer X;
+    InputBuffer Y;
+    if (!X.acquire(X_object, "X") || !Y.acquire(Y_object, "Y")) return nullptr;
+
+    const int input_size = self->model->get_input_size();
+    const int output_size = self->model->get_output_size();
+    if (X.size() != X.rows() * input_size || Y.rows() != X.rows() || Y.size() != Y.rows() * output_size) {
+        PyErr_Format(PyExc_ValueError, "expected X of shape (samples, %d) and Y of shape (samples, %d)",
+                     input_size, output_size);
+        return nullptr;
+    }
+
+    TrainingResults results;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        const MemoryDataSource data(X.data(), input_size, Y.data(), output_size, X.rows());
+        results = self->model->train(data, num_iter, lr, train_proportion, error_list_size,
+                                     early_stopping, 256, false);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
+    return training_results(std::move(results));
+}
+
+PyObject* MLP_train_from_file(MLPObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"dataset_path", "num_iter", "lr", "train_proportion", "error_list_size",
+                                     "batch_size", "patience", "restore_best", "checkpoint_path", "checkpoint_every",
+                                     nullptr};
+    const char* dataset_path = nullptr;
+    int num_iter = 1000;
+    double lr = 0.01;
+    double train_proportion = 0.8;
+    int error_list_size = 1000;
+    int batch_size = 256;
+    EarlyStoppingOptions early_stopping;
+    int restore_best = 1;
+    const char* checkpoint_path = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|iddiiipzi", const_cast<char**>(keywords),
+                                     &dataset_path, &num_iter, &lr, &train_proportion, &error_list_size,
+                                     &batch_size, &early_stopping.patience, &restore_best, &checkpoint_path,
+                                     &early_stopping.checkpoint_every) || !check_model(self)) {
+        return nullptr;
+    }
+    if (error_list_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "error_list_size must be > 0");
+        return nullptr;
+    }
+    early_stopping.restore_best = restore_best != 0;
+    early_stopping.checkpoint_path = checkpoint_path != nullptr ? checkpoint_path : "";
+
+    TrainingResults results;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> guard(*self->lock);
+        const BinaryDataSource data((std::string(dataset_path)));
+        results = self->model->train(data, num_iter, lr, train_proportion, error_list_size,
+                                     early_stopping, batch_size, true);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
+    return training_results(std::move(results));
+}
+
+PyObject* MLP_get_weights(MLPObject* self, PyObject*) {
+    if (!check_model(self)) return nullptr;
+
+    const std::vector<Eigen::MatrixXd>& weights = *self->model->get_weights();
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(weights.size()) - 1);
+    if (list == nullptr) return nullptr;
+
+    for (size_t l = 1; l < weights.size(); l++) {
+        PyObject* view = matrix_view(reinterpret_cast<PyObject*>(self), weights[l]);
+        if (view == nullptr) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(l) - 1, view);
+    }
+    return list;
+}
+
+PyObject* MLP_get_layers(MLPObject* self, void*) {
+    if (!check_model(self)) return nullptr;
+
+    const Eigen::VectorXi& NPL = *self->model->get_neuron_per_layer();
+    PyObject* list = PyList_New(NPL.size());
+    if (list == nullptr) return nullptr;
+    for (Eigen::Index l = 0; l < NPL.size(); l++) {
+        PyList_SET_ITEM(list, l, PyLong_FromLong(NPL(l)));
+    }
+    return list;
+}
+
+PyMethodDef MLP_methods[] = {
+    {"load", MLP_load, METH_VARARGS | METH_STATIC, "load(filepath) -> MLP, read a .bin model"},
+    {"save", reinterpret_cast<PyCFunction>(MLP_save), METH_VARARGS, "save(filepath)"},
+    {"predict", reinterpret_cast<PyCFunction>(MLP_predict), METH_VARARGS,
+     "predict(x) -> array of the outputs, x holds input_size float64"},
+    {"predict_batch", reinterpret_cast<PyCFunction>(MLP_predict_batch), METH_VARARGS,
+     "predict_batch(X) -> (samples, outputs) array, X of shape (samples, input_size)"},
+    {"train", reinterpret_cast<PyCFunction>(MLP_train), METH_VARARGS | METH_KEYWORDS,
+     "train(X, Y, num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000, patience=0, "
+     "restore_best=True, checkpoint_path=None, checkpoint_every=0) -> (train_errors, test_errors, best_index)\n"
+     "X of shape (samples, input_size) and Y of shape (samples, output_size), read without copy"},
+    {"train_from_file", reinterpret_cast<PyCFunction>(MLP_train_from_file), METH_VARARGS | METH_KEYWORDS,
+     "train_from_file(dataset_path, num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000, "
+     "batch_size=256, patience=0, restore_best=True, checkpoint_path=None, checkpoint_every=0) "
+     "-> (train_errors, test_errors, best_index)"},
+    {"get_weights", reinterpret_cast<PyCFunction>(MLP_get_weights), METH_NOARGS,
+     "get_weights() -> list of read-only views on W[1..L], shape (previous layer + 1, layer + 1)"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyGetSetDef MLP_getset[] = {
+    {"layers", reinterpret_cast<getter>(MLP_get_layers), nullptr, "neurons per layer", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+// ============= module functions ================
+
+PyObject* write_dataset(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"X", "Y", "filepath", "append", "sample_weights", nullptr};
+    PyObject* X_object = nullptr;
+    PyObject* Y_object = nullptr;
+    const char* filepath = nullptr;
+    int append = 0;
+    PyObject* weights_object = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOs|pO", const_cast<char**>(keywords),
+                                     &X_object, &Y_object, &filepath, &append, &weights_object)) {
+        return nullptr;
+    }
+
+    InputBuffer X;
+    InputBuffer Y;
+    InputBuffer weights;
+    if (!X.acquire(X_object, "X") || !Y.acquire(Y_object, "Y")) return nullptr;
+    if (X.rows() != Y.rows() || X.rows() == 0) {
+        PyErr_SetString(PyExc_ValueError, "X and Y must have the same number of samples (rows)");
+        return nullptr;
+    }
+    if (weights_object != Py_None) {
+        if (!weights.acquire(weights_object, "sample_weights")) return nullptr;
+        if (weights.size() != X.rows()) {
+            PyErr_SetString(PyExc_ValueError, "sample_weights must have one value per sample (row)");
+            return nullptr;
+        }
+    }
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        const MemoryDataSource data(X.data(), X.size() / X.rows(), Y.data(), Y.size() / Y.rows(), X.rows(),
+                                    weights.acquired ? weights.data() : nullptr);
+        BinaryDataSource::write(filepath, data, append != 0);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyMethodDef module_methods[] = {
+    {"write_dataset", reinterpret_cast<PyCFunction>(write_dataset), METH_VARARGS | METH_KEYWORDS,
+     "write_dataset(X, Y, filepath, append=False, sample_weights=None), compact int16 file for "
+     "MLP.train_from_file, X and Y with one sample per row, the sample weights stored with them"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyModuleDef module_definition = {
+    PyModuleDef_HEAD_INIT,
+    "ml_lib_native",
+    "Native bindings of ML_lib (zero-copy numpy buffers, GIL released during train and predict)",
+    -1,
+    module_methods,
+};
+
+}
+
+PyMODINIT_FUNC PyInit_ml_lib_native() {
+    NativeArrayType.tp_basicsize = sizeof(NativeArrayObject);
+    NativeArrayType.tp_dealloc = reinterpret_cast<destructor>(NativeArray_dealloc);
+    NativeArrayType.tp_as_buffer = &NativeArray_as_buffer;
+    NativeArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+    NativeArrayType.tp_doc = "float64 memory owned by ML_lib, exported through the buffer protocol";
+    if (PyType_Ready(&NativeArrayType) < 0) return nullptr;
+
+    MLPType.tp_basicsize = sizeof(MLPObject);
+    MLPType.tp_dealloc = reinterpret_cast<destructor>(MLP_dealloc);
+    MLPType.tp_flags = Py_TPFLAGS_DEFAULT;
+    MLPType.tp_doc = "MLP(layers, is_classification=True)";
+    MLPType.tp_methods = MLP_methods;
+    MLPType.tp_getset = MLP_getset;
+    MLPType.tp_init = reinterpret_cast<initproc>(MLP_init);
+    MLPType.tp_new = MLP_new;
+    if (PyType_Ready(&MLPType) < 0) return nullptr;
+
+    // numpy is optional, results are plain memoryviews without it
+    if (PyObject* numpy = PyImport_ImportModule("numpy")) {
+        numpy_asarray = PyObject_GetAttrString(numpy, "asarray");
+        Py_DECREF(numpy);
+    }
+    PyErr_Clear();
+
+    PyObject* module = PyModule_Create(&module_definition);
+    if (module == nullptr) return nullptr;
+
+    Py_INCREF(&MLPType);
+    if (PyModule_AddObject(module, "MLP", reinterpret_cast<PyObject*>(&MLPType)) < 0) {
+        Py_DECREF(&MLPType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -144,6 +144,47 @@ lib.train_mlp.argtypes = [
 ]
 lib.train_mlp.restype = None
 
+lib.train_mlp_early_stopping.argtypes = [
+    ctypes.c_void_p,                                      # model
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),      # out_train_error
+    ctypes.POINTER(ctypes.c_int32),                       # out_train_size
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),      # out_test_error
+    ctypes.POINTER(ctypes.c_int32),                       # out_test_size
+    ctypes.POINTER(ctypes.c_int32),                       # out_best_index
+    ctypes.c_int32,   # num_iter
+    ctypes.c_float,   # learning_rate
+    ctypes.c_double,  # train_proportion
+    ctypes.c_int32,   # error_list_size
+    ctypes.c_int32,   # patience
+    ctypes.c_bool,    # restore_best
+    ctypes.c_char_p,  # checkpoint_path (None = no checkpoint)
+    ctypes.c_int32,   # checkpoint_every
+    ctypes.POINTER(ctypes.c_double)  # sample_weights (None = uniform)
+]
+lib.train_mlp_early_stopping.restype = ctypes.c_bool
+
+lib.train_mlp_from_file.argtypes = [
+    ctypes.c_void_p,                                      # model
+    ctypes.c_char_p,                                      # dataset_path
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),      # out_train_error
+    ctypes.POINTER(ctypes.c_int32),                       # out_train_size
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),      # out_test_error
+    ctypes.POINTER(ctypes.c_int32),                       # out_test_size
+    ctypes.POINTER(ctypes.c_int32),                       # out_best_index
+    ctypes.c_int32,   # num_iter
+    ctypes.c_float,   # learning_rate
+    ctypes.c_double,  # train_proportion
+    ctypes.c_int32,   # error_list_size
+    ctypes.c_int32,   # batch_size
+    ctypes.c_int32,   # patience
+    ctypes.c_bool,    # restore_best
+    ctypes.c_char_p,  # checkpoint_path (None = no checkpoint)
+    ctypes.c_int32    # checkpoint_every
+]
+lib.train_mlp_from_file.restype = ctypes.c_bool
+
 lib.release_mlp.argtypes = [ctypes.c_void_p]
 lib.release_mlp.restype = None
 
@@ -153,6 +194,151 @@ lib.save_mlp_model.restype = None
 lib.load_mlp_model.argtypes = [ctypes.c_char_p]
 lib.load_mlp_model.restype = ctypes.c_void_p # Returns pointer to new MLP
 
+lib.get_mlp_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_bool]
+lib.get_mlp_stats.restype = None
+
+lib.reset_mlp_load_stats.argtypes = []
+lib.reset_mlp_load_stats.restype = None
+
+lib.prune_mlp.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_bool, ctypes.c_bool] # sparsity, per_layer, structured
+lib.prune_mlp.restype = ctypes.c_bool
+
+lib.clear_mlp_mask.argtypes = [ctypes.c_void_p]
+lib.clear_mlp_mask.restype = None
+
+lib.get_mlp_density.argtypes = [ctypes.c_void_p]
+lib.get_mlp_density.restype = ctypes.c_double
+
+lib.save_mlp_model_sparse.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.save_mlp_model_sparse.restype = None
+
+# ===== Dataset file bindings =====
+
+lib.write_int16_dataset.argtypes = [
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+    ctypes.POINTER(ctypes.c_double), # sample_weights (optional)
+    ctypes.c_char_p,  # filepath
+    ctypes.c_bool     # append
+]
+lib.write_int16_dataset.restype = ctypes.c_bool
+
+lib.compact_dataset.argtypes = [
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), # out_X
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), # out_Y
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), # out_weights
+    ctypes.POINTER(ctypes.c_int32), # out_count
+    ctypes.POINTER(ctypes.c_int32)  # out_conflicts
+]
+lib.compact_dataset.restype = ctypes.c_bool
+
+# ===== MLP ensemble bindings =====
+
+lib.create_mlp_ensemble.argtypes = [
+    ctypes.POINTER(ctypes.c_void_p),  # models pointer
+    ctypes.c_int32                    # number of models
+]
+lib.create_mlp_ensemble.restype = ctypes.c_void_p # NULL if models can't be combined
+
+lib.predict_one_mlp_ensemble.argtypes = [
+    ctypes.c_void_p,
+    ctypes.POINTER(ctypes.c_double),
+    ctypes.c_int32,
+    ctypes.c_int32,                   # mode: 0 = average, 1 = vote
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),
+    ctypes.POINTER(ctypes.c_int32)
+]
+lib.predict_one_mlp_ensemble.restype = ctypes.c_bool # False if the input size or the mode is invalid
+
+lib.release_mlp_ensemble.argtypes = [ctypes.c_void_p]
+lib.release_mlp_ensemble.restype = None
+
+# ===== Hyperparameter sweep bindings =====
+
+lib.run_mlp_sweep.argtypes = [
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+    ctypes.POINTER(ctypes.c_int32),   # npl_data (topologies one after another)
+    ctypes.POINTER(ctypes.c_int32),   # npl_sizes
+    ctypes.c_int32,                   # topology_count
+    ctypes.POINTER(ctypes.c_int32), ctypes.c_int32,   # num_iters, count
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32,  # learning_rates, count
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32,  # train_proportions, count
+    ctypes.c_int32,                   # random_count (0 = grid)
+    ctypes.c_uint32,                  # seed
+    ctypes.c_bool,                    # is_classification
+    ctypes.c_int32,                   # error_list_size
+    ctypes.c_char_p,                  # output_dir
+    ctypes.c_int32,                   # thread_count (0 = all hardware threads)
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),  # out_errors
+    ctypes.POINTER(ctypes.c_int32)    # out_size
+]
+lib.run_mlp_sweep.restype = None
+
+# ===== Evolution strategies bindings =====
+
+# fitness(candidate MLP pointer, user_data) -> double, called from the worker threads
+MLP_FITNESS_CALLBACK = ctypes.CFUNCTYPE(ctypes.c_double, ctypes.c_void_p, ctypes.c_void_p)
+
+_evolution_options = [
+    ctypes.c_int32,   # population (even)
+    ctypes.c_int32,   # generations
+    ctypes.c_double,  # sigma
+    ctypes.c_double,  # learning_rate
+    ctypes.c_int32,   # thread_count (0 = all hardware threads)
+    ctypes.c_uint64,  # seed
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)),  # out_fitness ([center, mean] per generation)
+    ctypes.POINTER(ctypes.c_int32)    # out_size
+]
+
+lib.train_mlp_evolution.argtypes = [
+    ctypes.c_void_p,                                      # model
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+] + _evolution_options
+lib.train_mlp_evolution.restype = ctypes.c_bool
+
+lib.train_mlp_evolution_callback.argtypes = [
+    ctypes.c_void_p,        # model
+    MLP_FITNESS_CALLBACK,   # fitness
+    ctypes.c_void_p,        # user_data
+] + _evolution_options
+lib.train_mlp_evolution_callback.restype = ctypes.c_bool
+
+# ===== Distillation bindings =====
+
+lib.compute_teacher_outputs.argtypes = [
+    ctypes.c_void_p, # teacher MLP
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32 # X, rows, cols
+]
+lib.compute_teacher_outputs.restype = ctypes.c_void_p # NULL if X doesn't match the teacher
+
+lib.save_teacher_outputs.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.save_teacher_outputs.restype = None
+
+lib.load_teacher_outputs.argtypes = [ctypes.c_char_p]
+lib.load_teacher_outputs.restype = ctypes.c_void_p
+
+lib.release_teacher_outputs.argtypes = [ctypes.c_void_p]
+lib.release_teacher_outputs.restype = None
+
+lib.train_mlp_distilled.argtypes = [
+    ctypes.c_void_p, # student MLP
+    ctypes.c_void_p, # teacher outputs
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # X, rows, cols
+    ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_int32, # Y, rows, cols
+    ctypes.c_double, # teacher_weight
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), ctypes.POINTER(ctypes.c_int32), # train errors
+    ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), ctypes.POINTER(ctypes.c_int32), # test errors
+    ctypes.c_int32, # num_iter
+    ctypes.c_float, # learning_rate
+    ctypes.c_double, # train_proportion
+    ctypes.c_int32 # error_list_size
+]
+lib.train_mlp_distilled.restype = ctypes.c_bool
+
 def _to_c_ptr(arr: np.ndarray):
     arr = np.ascontiguousarray(arr, dtype=np.float64)
     return arr.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
@@ -368,14 +554,56 @@ class MLP:
         lib.free_buffer(out_ptr)
         return result_copy
 
-    def train(self, X: np.ndarray, Y: np.ndarray, num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000):
+    def get_stats(self, reset=False) -> dict:
+        """
+        Counters of this model since it was created / loaded (or since the last reset=True),
+        only predict and load calls are measured. Latencies are in microseconds.
+        The load values cover every MLP.load of the process, each load creates a new model:
+        reset=True leaves them, MLP.reset_load_stats() clears them.
         """
+        out = (ctypes.c_double * 9)()
+        lib.get_mlp_stats(self.model_ptr, out, reset)
+        return {
+            "predict_count": int(out[0]),
+            "predict_p50_us": out[1],
+            "predict_p99_us": out[2],
+            "predict_max_us": out[3],
+            "load_count": int(out[4]),
+            "load_p50_us": out[5],
+            "load_p99_us": out[6],
+            "load_max_us": out[7],
+            "bytes_allocated": int(out[8]),
+        }
+
+    @staticmethod
+    def reset_load_stats():
+        """Clears the load values of get_stats, shared by every model of the process."""
+        lib.reset_mlp_load_stats()
+
+    def train(self, X: np.ndarray, Y: np.ndarray, num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000,
+              patience=0, restore_best=True, checkpoint_path: str = None, checkpoint_every=0,
+              sample_weights: np.ndarray = None):
+        """
+        patience > 0 stops when the test error didn't improve for that many evaluations.
+        checkpoint_path, checkpoint_every: the best weights are saved there every checkpoint_every evaluations.
+        With patience or checkpoints, the model ends with the best weights unless restore_best is False.
+        sample_weights: one weight per sample (column), e.g. the counts returned by compact_dataset.
+            A sample is drawn in proportion to the square root of its weight and its step is scaled
+            by a bounded importance weight, so it counts about as much as the rows it stands for.
+
         Returns:
-            tuple(np.ndarray, np.ndarray): (train_errors, test_errors)
+            tuple(np.ndarray, np.ndarray): (train_errors, test_errors), shortened if stopped early
         """
         X_ptr = _to_c_ptr(X)
         Y_ptr = _to_c_ptr(Y)
 
+        weights_ptr = None
+        if sample_weights is not None:
+            sample_weights = np.ascontiguousarray(sample_weights, dtype=np.float64)
+            if sample_weights.shape != (X.shape[1],):
+                raise ValueError(f"sample_weights must have one value per sample ({X.shape[1]})")
+            weights_ptr = _to_c_ptr(sample_weights)
+
         # Prepare pointers for Train Error results
         out_train_err_ptr = ctypes.POINTER(ctypes.c_double)()
         out_train_size = ctypes.c_int32()
@@ -384,7 +612,9 @@ class MLP:
         out_test_err_ptr = ctypes.POINTER(ctypes.c_double)()
         out_test_size = ctypes.c_int32()
 
-        lib.train_mlp(
+        out_best_index = ctypes.c_int32()
+
+        ok = lib.train_mlp_early_stopping(
             self.model_ptr,
             X_ptr, X.shape[0], X.shape[1],
             Y_ptr, Y.shape[0], Y.shape[1],
@@ -396,12 +626,23 @@ class MLP:
             # Pass references for Test outputs
             ctypes.byref(out_test_err_ptr),
             ctypes.byref(out_test_size),
+
+            ctypes.byref(out_best_index),
             
             num_iter,
             lr,
             train_proportion,
-            error_list_size
+            error_list_size,
+            patience,
+            restore_best,
+            checkpoint_path.encode('utf-8') if checkpoint_path else None,
+            checkpoint_every,
+            weights_ptr
         )
+        if not ok:
+            raise ValueError("Training failed (sizes not matching the model, invalid sample_weights or options)")
+
+        self.best_error_index = out_best_index.value
 
         # 1. Process Train Errors
         train_err = np.ctypeslib.as_array(out_train_err_ptr, shape=(out_train_size.value,))
@@ -415,6 +656,140 @@ class MLP:
 
         return train_err_copy, test_err_copy
 
+    def train_from_file(self, dataset_path: str, num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000,
+                        batch_size=256, patience=0, restore_best=True, checkpoint_path: str = None, checkpoint_every=0):
+        """
+        Same as train, but the samples are read from a file written by write_dataset
+        (memory mapped, never fully loaded), with the sample_weights stored in the file if any.
+
+        Returns:
+            tuple(np.ndarray, np.ndarray): (train_errors, test_errors)
+        """
+        out_train_err_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_train_size = ctypes.c_int32()
+        out_test_err_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_test_size = ctypes.c_int32()
+        out_best_index = ctypes.c_int32()
+
+        ok = lib.train_mlp_from_file(
+            self.model_ptr,
+            dataset_path.encode('utf-8'),
+            ctypes.byref(out_train_err_ptr),
+            ctypes.byref(out_train_size),
+            ctypes.byref(out_test_err_ptr),
+            ctypes.byref(out_test_size),
+            ctypes.byref(out_best_index),
+            num_iter,
+            lr,
+            train_proportion,
+            error_list_size,
+            batch_size,
+            patience,
+            restore_best,
+            checkpoint_path.encode('utf-8') if checkpoint_path else None,
+            checkpoint_every
+        )
+
+        if not ok:
+            raise IOError(f"Could not train from {dataset_path} (missing file or sizes not matching the model)")
+
+        self.best_error_index = out_best_index.value
+
+        train_err = np.ctypeslib.as_array(out_train_err_ptr, shape=(out_train_size.value,))
+        train_err_copy = np.copy(train_err)
+        lib.free_buffer(out_train_err_ptr)
+
+        test_err = np.ctypeslib.as_array(out_test_err_ptr, shape=(out_test_size.value,))
+        test_err_copy = np.copy(test_err)
+        lib.free_buffer(out_test_err_ptr)
+
+        return train_err_copy, test_err_copy
+
+    def train_distilled(self, teacher_outputs: "TeacherOutputs", X: np.ndarray, Y: np.ndarray, teacher_weight=1.0,
+                        num_iter=1000, lr=0.01, train_proportion=0.8, error_list_size=1000):
+        """
+        Trains toward the teacher outputs (computed on the same X) instead of the recorded actions,
+        mixed as teacher_weight * teacher + (1 - teacher_weight) * Y.
+
+        Returns:
+            tuple(np.ndarray, np.ndarray): (train_errors, test_errors), against the mixed targets
+        """
+        X_ptr = _to_c_ptr(X)
+        Y_ptr = _to_c_ptr(Y)
+
+        out_train_err_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_train_size = ctypes.c_int32()
+        out_test_err_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_test_size = ctypes.c_int32()
+
+        ok = lib.train_mlp_distilled(
+            self.model_ptr,
+            teacher_outputs.outputs_ptr,
+            X_ptr, X.shape[0], X.shape[1],
+            Y_ptr, Y.shape[0], Y.shape[1],
+            teacher_weight,
+            ctypes.byref(out_train_err_ptr),
+            ctypes.byref(out_train_size),
+            ctypes.byref(out_test_err_ptr),
+            ctypes.byref(out_test_size),
+            num_iter,
+            lr,
+            train_proportion,
+            error_list_size
+        )
+
+        if not ok:
+            raise ValueError("X, Y and the teacher outputs must have the same samples and match the student sizes")
+
+        train_err = np.copy(np.ctypeslib.as_array(out_train_err_ptr, shape=(out_train_size.value,)))
+        lib.free_buffer(out_train_err_ptr)
+        test_err = np.copy(np.ctypeslib.as_array(out_test_err_ptr, shape=(out_test_size.value,)))
+        lib.free_buffer(out_test_err_ptr)
+
+        return train_err, test_err
+
+    def train_evolution(self, X: np.ndarray = None, Y: np.ndarray = None, fitness=None, population=64,
+                        generations=100, sigma=0.02, lr=0.01, thread_count=0, seed=0):
+        """
+        Gradient free training (evolution strategies) from the current weights, e.g. a model from MLP.load.
+        The fitness is the accuracy on X/Y (one sample per column), or fitness(candidate: MLP) -> float
+        when given (e.g. a game score, higher is better). A Python fitness holds the GIL, so its candidates
+        are evaluated one at a time whatever thread_count is.
+
+        Returns:
+            np.ndarray: (generations, 2) fitness of the unperturbed weights and mean of the population
+        """
+        out_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_size = ctypes.c_int32()
+        options = (population, generations, sigma, lr, thread_count, seed, ctypes.byref(out_ptr), ctypes.byref(out_size))
+
+        if fitness is not None:
+            def call(candidate_ptr, _user_data):
+                candidate = MLP(layers=[], _existing_ptr=candidate_ptr)
+                try:
+                    return float(fitness(candidate))
+                finally:
+                    candidate.model_ptr = None  # owned by the trainer
+
+            callback = MLP_FITNESS_CALLBACK(call)
+            ok = lib.train_mlp_evolution_callback(self.model_ptr, callback, None, *options)
+        else:
+            if X is None or Y is None:
+                raise ValueError("X and Y are needed without a fitness function")
+            ok = lib.train_mlp_evolution(
+                self.model_ptr,
+                _to_c_ptr(X), X.shape[0], X.shape[1],
+                _to_c_ptr(Y), Y.shape[0], Y.shape[1],
+                *options
+            )
+
+        if not ok:
+            raise ValueError("Evolution training failed (population must be even, sigma > 0, X/Y matching the model)")
+
+        history = np.copy(np.ctypeslib.as_array(out_ptr, shape=(out_size.value,))).reshape(-1, 2)
+        lib.free_buffer(out_ptr)
+        return history
+
     def release(self):
         lib.release_mlp(self.model_ptr)
 
@@ -423,6 +798,27 @@ class MLP:
         b_path = filepath.encode('utf-8')
         lib.save_mlp_model(self.model_ptr, b_path)
 
+    def save_sparse(self, filepath: str):
+        """Only the non zero weights are written (smaller for pruned models), load reads both formats."""
+        lib.save_mlp_model_sparse(self.model_ptr, filepath.encode('utf-8'))
+
+    def prune(self, sparsity: float, per_layer=False, structured=False):
+        """
+        Sets the share sparsity of the smallest hidden layer weights to 0, over the whole net or in each
+        layer (per_layer). The output layer isn't pruned and each hidden layer keeps at least 5% of its weights.
+        structured prunes blocks of 4 weights, which runs faster. The pruned weights stay at 0 in
+        the next train calls (fine-tuning) until clear_mask is called.
+        """
+        if not lib.prune_mlp(self.model_ptr, sparsity, per_layer, structured):
+            raise ValueError(f"sparsity must be between 0 and 1 and the model needs a hidden layer, got {sparsity}")
+
+    def clear_mask(self):
+        lib.clear_mlp_mask(self.model_ptr)
+
+    def density(self) -> float:
+        """Share of non zero weights (the bias neuron weights, never pruned, aren't counted)."""
+        return lib.get_mlp_density(self.model_ptr)
+
     @staticmethod
     def load(filepath: str):
         b_path = filepath.encode('utf-8')
@@ -438,3 +834,205 @@ class MLP:
     def __del__(self):
         if hasattr(self, "model_ptr") and self.model_ptr:
             self.release()
+
+def write_dataset(X: np.ndarray, Y: np.ndarray, filepath: str, append: bool = False,
+                  sample_weights: np.ndarray = None):
+    """
+    Writes X and Y (one sample per column, like MLP.train) as a compact int16 file for MLP.train_from_file.
+    Use append=True to convert a big dataset one chunk at a time.
+    sample_weights: one weight per sample, e.g. the output of compact_dataset. They are stored in the file
+        (the targets then as doubles, so the soft targets of compact_dataset fit) and used by train_from_file.
+        All the chunks of a file must have weights, or none.
+    """
+    X_ptr = _to_c_ptr(X)
+    Y_ptr = _to_c_ptr(Y)
+
+    weights_ptr = None
+    if sample_weights is not None:
+        sample_weights = np.ascontiguousarray(sample_weights, dtype=np.float64)
+        if sample_weights.shape != (X.shape[1],):
+            raise ValueError(f"sample_weights must have one value per sample ({X.shape[1]})")
+        weights_ptr = _to_c_ptr(sample_weights)
+
+    ok = lib.write_int16_dataset(
+        X_ptr, X.shape[0], X.shape[1],
+        Y_ptr, Y.shape[0], Y.shape[1],
+        weights_ptr,
+        filepath.encode('utf-8'),
+        append
+    )
+
+    if not ok:
+        raise ValueError(f"Could not write {filepath} (X must be integers in the int16 range, Y too without "
+                         "sample_weights, weights >= 0, same sizes and weighting as the file when appending)")
+
+
+def compact_dataset(X: np.ndarray, Y: np.ndarray):
+    """
+    Merges the identical states of X (one sample per column, like MLP.train). The targets of a state
+    become the mean of its recorded targets (soft targets when they disagree).
+
+    Returns:
+        tuple(np.ndarray, np.ndarray, np.ndarray, int): (X_unique, Y_unique, weights, conflict_count),
+        weights is the number of samples merged into each column, to give to MLP.train or write_dataset
+        as sample_weights
+    """
+    X_ptr = _to_c_ptr(X)
+    Y_ptr = _to_c_ptr(Y)
+
+    out_X = ctypes.POINTER(ctypes.c_double)()
+    out_Y = ctypes.POINTER(ctypes.c_double)()
+    out_weights = ctypes.POINTER(ctypes.c_double)()
+    out_count = ctypes.c_int32()
+    out_conflicts = ctypes.c_int32()
+
+    ok = lib.compact_dataset(
+        X_ptr, X.shape[0], X.shape[1],
+        Y_ptr, Y.shape[0], Y.shape[1],
+        ctypes.byref(out_X), ctypes.byref(out_Y), ctypes.byref(out_weights),
+        ctypes.byref(out_count), ctypes.byref(out_conflicts)
+    )
+
+    if not ok:
+        raise ValueError("Could not compact the dataset (X and Y must have the same samples, X integers in the int16 range)")
+
+    count = out_count.value
+    X_unique = np.copy(np.ctypeslib.as_array(out_X, shape=(X.shape[0], count))) if count else np.zeros((X.shape[0], 0))
+    Y_unique = np.copy(np.ctypeslib.as_array(out_Y, shape=(Y.shape[0], count))) if count else np.zeros((Y.shape[0], 0))
+    weights = np.copy(np.ctypeslib.as_array(out_weights, shape=(count,))) if count else np.zeros(0)
+    lib.free_buffer(out_X)
+    lib.free_buffer(out_Y)
+    lib.free_buffer(out_weights)
+
+    return X_unique, Y_unique, weights, out_conflicts.value
+
+
+def run_sweep(X: np.ndarray, Y: np.ndarray, topologies: list[list[int]], num_iters: list[int],
+              learning_rates: list[float], train_proportions: list[float], output_dir: str,
+              random_count: int = 0, seed: int = 0, is_classification: bool = True,
+              error_list_size: int = 100, thread_count: int = 0) -> np.ndarray:
+    """
+    Trains every config natively over a thread pool and saves the models in output_dir
+    following the Models/ naming convention (plus sweep-summary.csv).
+    X and Y are given like for MLP.train (one sample per column).
+    random_count == 0 runs the full grid, otherwise random_count configs are drawn with
+    the learning rate log-uniform between learning_rates[0] and learning_rates[1].
+
+    Returns:
+        np.ndarray: (n_configs, 2) array of final (train_mse, test_mse), NaN for a config
+        whose training failed (the reason is in the error column of sweep-summary.csv)
+    """
+    X_ptr = _to_c_ptr(X)
+    Y_ptr = _to_c_ptr(Y)
+
+    npl_flat = [n for layers in topologies for n in layers]
+    npl_data = (ctypes.c_int32 * len(npl_flat))(*npl_flat)
+    npl_sizes = (ctypes.c_int32 * len(topologies))(*[len(layers) for layers in topologies])
+    iters = (ctypes.c_int32 * len(num_iters))(*num_iters)
+    lrs = (ctypes.c_double * len(learning_rates))(*learning_rates)
+    proportions = (ctypes.c_double * len(train_proportions))(*train_proportions)
+
+    out_ptr = ctypes.POINTER(ctypes.c_double)()
+    out_size = ctypes.c_int32()
+
+    lib.run_mlp_sweep(
+        X_ptr, X.shape[0], X.shape[1],
+        Y_ptr, Y.shape[0], Y.shape[1],
+        npl_data, npl_sizes, len(topologies),
+        iters, len(num_iters),
+        lrs, len(learning_rates),
+        proportions, len(train_proportions),
+        random_count, seed,
+        is_classification, error_list_size,
+        output_dir.encode('utf-8'), thread_count,
+        ctypes.byref(out_ptr),
+        ctypes.byref(out_size)
+    )
+
+    if out_size.value == 0:
+        raise RuntimeError("Hyperparameter sweep failed")
+
+    errors = np.ctypeslib.as_array(out_ptr, shape=(out_size.value,))
+    errors_copy = np.copy(errors).reshape((-1, 2))
+    lib.free_buffer(out_ptr)
+    return errors_copy
+
+
+class MLPEnsemble:
+    AVERAGE = 0
+    VOTE = 1
+
+    def __init__(self, models: list[MLP]):
+        """
+        The weights of the models are copied, training a model afterward doesn't change the ensemble.
+        """
+        arr = (ctypes.c_void_p * len(models))(*[m.model_ptr for m in models])
+        self.ensemble_ptr = lib.create_mlp_ensemble(arr, len(models))
+
+        if not self.ensemble_ptr:
+            raise ValueError("Models must share the same input and output size")
+
+    def predict(self, x: np.ndarray, mode: int = AVERAGE) -> np.ndarray:
+        x = np.asarray(x, dtype=np.float64)
+        x_ptr = _to_c_ptr(x)
+
+        out_ptr = ctypes.POINTER(ctypes.c_double)()
+        out_size = ctypes.c_int32()
+
+        ok = lib.predict_one_mlp_ensemble(
+            self.ensemble_ptr,
+            x_ptr,
+            x.size,
+            mode,
+            ctypes.byref(out_ptr),
+            ctypes.byref(out_size)
+        )
+        if not ok:
+            raise ValueError("Input size not matching the ensemble or unknown mode (AVERAGE or VOTE)")
+
+        result = np.ctypeslib.as_array(out_ptr, shape=(out_size.value,))
+        result_copy = np.copy(result)
+
+        lib.free_buffer(out_ptr)
+        return result_copy
+
+    def release(self):
+        lib.release_mlp_ensemble(self.ensemble_ptr)
+
+    def __del__(self):
+        if hasattr(self, "ensemble_ptr") and self.ensemble_ptr:
+            self.release()
+
+
+class TeacherOutputs:
+    def __init__(self, teacher: MLP = None, X: np.ndarray = None, _existing_ptr=None):
+        """
+        Outputs of the teacher on every sample of X, computed once by batches in C++.
+        Reuse the same object to distill several students on this X.
+        """
+        if _existing_ptr:
+            self.outputs_ptr = _existing_ptr
+            return
+
+        X_ptr = _to_c_ptr(X)
+        self.outputs_ptr = lib.compute_teacher_outputs(teacher.model_ptr, X_ptr, X.shape[0], X.shape[1])
+
+        if not self.outputs_ptr:
+            raise ValueError("X doesn't match the teacher input size")
+
+    def save(self, filepath: str):
+        lib.save_teacher_outputs(self.outputs_ptr, filepath.encode('utf-8'))
+
+    @staticmethod
+    def load(filepath: str):
+        ptr = lib.load_teacher_outputs(filepath.encode('utf-8'))
+        if not ptr:
+            raise IOError(f"Could not load teacher outputs from {filepath}")
+        return TeacherOutputs(_existing_ptr=ptr)
+
+    def release(self):
+        lib.release_teacher_outputs(self.outputs_ptr)
+
+    def __del__(self):
+        if hasattr(self, "outputs_ptr") and self.outputs_ptr:
+            self.release()
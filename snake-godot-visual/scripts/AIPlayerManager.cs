@@ -12,7 +12,14 @@ public partial class AIPlayerManager : Node
     
     [Export] private int stuckThreshold = 100;
     
+    // lookahead on the game rules with the model as a move prior, instead of its argmax
+    [Export] private bool useSearch = false;
+    [Export] private double searchBudgetMs = 5.0;
+    [Export] private int searchThreads = 0;
+    [Export] private bool logSearch = false; // prints the search stats on every tick
+    
     private MLP _mlp;
+    private SearchAgent _searchAgent;
     private static IntPtr _dllHandle = IntPtr.Zero;
     
     private Random _rng = new Random();
@@ -87,6 +94,11 @@ public partial class AIPlayerManager : Node
                 {
                     _mlp = MLP.Load(absoluteModelPath); 
                     GD.Print($"Successfully loaded Model from: {absoluteModelPath}");
+
+                    if (useSearch)
+                    {
+                        _searchAgent = new SearchAgent(_mlp, timeBudgetMs: searchBudgetMs, threadCount: searchThreads);
+                    }
                 }
             }
             catch (Exception e)
@@ -104,6 +116,17 @@ public partial class AIPlayerManager : Node
             return new bool[4]; // Return empty/default move
         }
         
+        if (_searchAgent != null)
+        {
+            bool[] searched = _searchAgent.NextAction(gameState);
+            if (logSearch)
+            {
+                SearchStats stats = _searchAgent.LastStats;
+                GD.Print($"Search depth {stats.Depth}, {stats.Nodes} nodes, {stats.Evaluated} evaluated in {stats.ElapsedUs:F0} us");
+            }
+            return searched;
+        }
+        
         int currentScore = gameState[1];
 
         if (currentScore != _lastScore)
@@ -177,6 +200,7 @@ public partial class AIPlayerManager : Node
     // Cleanup when the node is destroyed
     public override void _ExitTree()
     {
+        _searchAgent?.Dispose();
         _mlp?.Dispose();
     }
 }
\ No newline at end of file